@@ -0,0 +1,85 @@
+/** @file
+  Implementacja areny, czyli obszaru pamięci zwalnianego w całości
+
+  Bloki mają rozmiar ARENA_BLOCK_SIZE, a większe przydziały dostają własny
+  blok. Zwolnienie do znacznika oddaje systemowi bloki przydzielone po nim
+  z wyjątkiem pierwszego zwykłego bloku areny, który jest zachowywany do
+  wywołania ArenaFree, żeby krótkie operacje nie wywoływały funkcji malloc.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "arena.h"
+#include "check_ptr.h"
+
+#include <stdlib.h>
+
+/**
+ * Rozmiar zwykłego bloku areny w bajtach.
+ */
+#define ARENA_BLOCK_SIZE ((size_t)64 << 10)
+
+/**
+ * Wyrównanie przydziałów w bajtach.
+ */
+#define ARENA_ALIGN sizeof(void *)
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    ArenaBlock *block = arena->block;
+
+    if (block == NULL || block->size - block->used < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        CHECK_PTR(block);
+
+        block->prev = arena->block;
+        block->size = block_size;
+        block->used = 0;
+        arena->block = block;
+    }
+
+    void *ptr = (char *)(block + 1) + block->used;
+
+    block->used += size;
+
+    return ptr;
+}
+
+ArenaMark ArenaGetMark(const Arena *arena) {
+    return (ArenaMark) {
+        .block = arena->block,
+        .used = arena->block == NULL ? 0 : arena->block->used
+    };
+}
+
+void ArenaRelease(Arena *arena, ArenaMark mark) {
+    while (arena->block != mark.block) {
+        ArenaBlock *prev = arena->block->prev;
+
+        if (prev == NULL && arena->block->size == ARENA_BLOCK_SIZE) {
+            arena->block->used = 0;
+
+            return;
+        }
+
+        free(arena->block);
+        arena->block = prev;
+    }
+
+    if (arena->block != NULL) {
+        arena->block->used = mark.used;
+    }
+}
+
+void ArenaFree(Arena *arena) {
+    while (arena->block != NULL) {
+        ArenaBlock *prev = arena->block->prev;
+
+        free(arena->block);
+        arena->block = prev;
+    }
+}
@@ -0,0 +1,71 @@
+/** @file
+  Interfejs areny, czyli obszaru pamięci zwalnianego w całości
+
+  Arena przydziela pamięć kolejnymi kawałkami dużych bloków, przesuwając
+  wskaźnik końca zajętej części. Pojedynczych przydziałów się nie zwalnia:
+  funkcja ArenaRelease zwalnia naraz wszystko, co przydzielono od
+  zapamiętanego znacznika, a funkcja ArenaFree całą pamięć areny.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * Blok pamięci areny.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *prev; ///< poprzednio przydzielony blok
+    size_t size; ///< rozmiar obszaru na dane w bajtach
+    size_t used; ///< liczba zajętych bajtów
+} ArenaBlock;
+
+/**
+ * Arena.
+ */
+typedef struct Arena {
+    ArenaBlock *block; ///< bieżący blok albo NULL
+} Arena;
+
+/**
+ * Znacznik zajętości areny.
+ */
+typedef struct ArenaMark {
+    ArenaBlock *block; ///< bieżący blok w chwili utworzenia znacznika
+    size_t used; ///< liczba zajętych bajtów tego bloku
+} ArenaMark;
+
+/**
+ * Przydziela pamięć w arenie. Pamięć jest wyrównana tak jak wskaźnik.
+ * @param[in, out] arena : arena
+ * @param[in] size : rozmiar w bajtach
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void *ArenaAlloc(Arena *arena, size_t size);
+
+/**
+ * Zapamiętuje zajętość areny.
+ * @param[in] arena : arena
+ * @return znacznik zajętości
+ */
+ArenaMark ArenaGetMark(const Arena *arena);
+
+/**
+ * Zwalnia naraz wszystkie przydziały wykonane od utworzenia znacznika.
+ * Znaczniki muszą być zwalniane w kolejności odwrotnej do tworzenia.
+ * @param[in, out] arena : arena
+ * @param[in] mark : znacznik zwrócony przez ArenaGetMark
+ */
+void ArenaRelease(Arena *arena, ArenaMark mark);
+
+/**
+ * Zwalnia całą pamięć areny. Arena pozostaje gotowa do ponownego użycia.
+ * @param[in, out] arena : arena
+ */
+void ArenaFree(Arena *arena);
+
+#endif /* __ARENA_H__ */
@@ -8,6 +8,8 @@
 #include "check_ptr.h"
 #include "calc_functions.h"
 #include "parser.h"
+#include "poly_cache.h"
+#include "poly_pool.h"
 
 #include <stdlib.h>
 #include <errno.h>
@@ -25,6 +27,12 @@
  */ 
 #define MAX_NUMBER_LENGTH 24
 
+/**
+ * Limit rozmiaru pamięci podręcznej wyników mnożenia, potęgowania i składania
+ * wielomianów (w bajtach) po jej włączeniu komendą CACHE_ON.
+ */
+#define CACHE_LIMIT ((size_t)64 << 20)
+
 /**
  * Łączy dwa napisy w jeden. 
  * W razie potrzeby realokuje @p s1, żeby nie zabrakło pamięci.
@@ -163,15 +171,10 @@ void CalcAdd(Stack *stack, size_t line_number) {
         return;
     }
 
-    Poly *p1 = StackPeek(stack);
-    Poly *p2 = StackPeekSecond(stack);
+    Poly p1 = StackTake(stack);
+    Poly p2 = StackTake(stack);
 
-    Poly r = PolyAdd(p1, p2);
-
-    StackPop(stack);
-    StackPop(stack);
-
-    StackPush(stack, r);
+    StackPush(stack, PolyAddOwn(p1, p2));
 }
 
 void CalcMul(Stack *stack, size_t line_number) {
@@ -181,15 +184,21 @@ void CalcMul(Stack *stack, size_t line_number) {
         return;
     }
 
-    Poly *p1 = StackPeek(stack);
-    Poly *p2 = StackPeekSecond(stack);
+    if (PolyIsEq(StackPeek(stack), StackPeekSecond(stack))) {
+        StackPop(stack);
+        Poly p = StackTake(stack);
 
-    Poly r = PolyMul(p1, p2);
+        StackPush(stack, PolySqr(&p));
 
-    StackPop(stack);
-    StackPop(stack);
+        PolyDestroy(&p);
+
+        return;
+    }
+
+    Poly p1 = StackTake(stack);
+    Poly p2 = StackTake(stack);
 
-    StackPush(stack, r);
+    StackPush(stack, PolyMulOwn(p1, p2));
 }
 
 void CalcNeg(Stack *stack, size_t line_number) {
@@ -199,11 +208,21 @@ void CalcNeg(Stack *stack, size_t line_number) {
         return;
     }
 
-    Poly p = PolyNeg(StackPeek(stack));
+    StackPush(stack, PolyNegOwn(StackTake(stack)));
+}
 
-    StackPop(stack);
+void CalcCache(bool on) {
+    PolyCacheSetLimit(on ? CACHE_LIMIT : 0);
+}
 
-    StackPush(stack, p);
+void CalcIntern(Stack *stack, size_t line_number) {
+    if (StackIsEmpty(stack)) {
+        fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
+
+        return;
+    }
+
+    StackPush(stack, PolyInternOwn(StackTake(stack)));
 }
 
 void CalcSub(Stack *stack, size_t line_number) {
@@ -213,15 +232,24 @@ void CalcSub(Stack *stack, size_t line_number) {
         return;
     }
 
-    Poly *p1 = StackPeek(stack);
-    Poly *p2 = StackPeekSecond(stack);
+    Poly p1 = StackTake(stack);
+    Poly p2 = StackTake(stack);
 
-    Poly r = PolySub(p1, p2);
+    StackPush(stack, PolySubOwn(p1, p2));
+}
 
-    StackPop(stack);
-    StackPop(stack);
+void CalcPow(Stack *stack, unsigned long long e, size_t line_number) {
+    if (StackIsEmpty(stack)) {
+        fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
+
+        return;
+    }
+
+    Poly p = StackTake(stack);
+
+    StackPush(stack, PolyPow(&p, e));
 
-    StackPush(stack, r);
+    PolyDestroy(&p);
 }
 
 void CalcIsEq(const Stack *stack, size_t line_number) {
@@ -268,6 +296,81 @@ void CalcAt(Stack *stack, long long x, size_t line_number) {
     StackPush(stack, p);
 }
 
+void CalcAtMany(Stack *stack, const poly_coeff_t xs[], size_t n, size_t line_number) {
+    if (StackIsEmpty(stack)) {
+        fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
+
+        return;
+    }
+
+    Poly *out = malloc(n * sizeof(Poly));
+    CHECK_PTR(out);
+
+    PolyAtMany(StackPeek(stack), xs, n, out);
+
+    StackPop(stack);
+
+    for (size_t i = 0; i < n; i++) {
+        StackPush(stack, out[i]);
+    }
+
+    free(out);
+}
+
+void CalcEval(const Stack *stack, const poly_coeff_t x[], size_t k, size_t line_number) {
+    if (StackIsEmpty(stack)) {
+        fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
+
+        return;
+    }
+
+    printf("%ld\n", PolyEval(StackPeek(stack), x, k));
+}
+
+void CalcCompile(const Stack *stack, PolyProgram *program, bool *compiled, size_t line_number) {
+    if (StackIsEmpty(stack)) {
+        fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
+
+        return;
+    }
+
+    if (*compiled) {
+        PolyProgramDestroy(program);
+    }
+
+    *program = PolyCompile(StackPeek(stack));
+    *compiled = true;
+}
+
+void CalcRunProgram(const PolyProgram *program, bool compiled, const poly_coeff_t xs[], size_t count,
+                    size_t line_number) {
+    if (!compiled) {
+        fprintf(stderr, "ERROR %ld NO PROGRAM\n", line_number);
+
+        return;
+    }
+
+    size_t k = PolyProgramArity(program);
+
+    if (count % k != 0) {
+        fprintf(stderr, "ERROR %ld RUN WRONG VALUE\n", line_number);
+
+        return;
+    }
+
+    size_t n = count / k;
+    poly_coeff_t *out = malloc(n * sizeof(poly_coeff_t));
+    CHECK_PTR(out);
+
+    PolyProgramRun(program, n, k, xs, out);
+
+    for (size_t j = 0; j < n; j++) {
+        printf("%ld\n", out[j]);
+    }
+
+    free(out);
+}
+
 void CalcCompose(Stack *stack, unsigned long long k, size_t line_number) {
     if (stack->size <= k) {
         fprintf(stderr, "ERROR %ld STACK UNDERFLOW\n", line_number);
@@ -275,15 +378,12 @@ void CalcCompose(Stack *stack, unsigned long long k, size_t line_number) {
         return;
     }
 
-    Poly p = PolyClone(StackPeek(stack));
-    StackPop(stack);
+    Poly p = StackTake(stack);
 
     Poly *q = malloc(k * sizeof(Poly));
     CHECK_PTR(q);
     for (size_t i = 0; i < k; i++) {
-        q[k - i - 1] = PolyClone(StackPeek(stack));
-
-        StackPop(stack);
+        q[k - i - 1] = StackTake(stack);
     }
 
     StackPush(stack, PolyCompose(&p, k, q));
@@ -343,6 +443,15 @@ void CalcExecute(Stack *stack, size_t line_number, int command) {
     else if (command == NEG) {
         CalcNeg(stack, line_number);
     }
+    else if (command == INTERN) {
+        CalcIntern(stack, line_number);
+    }
+    else if (command == CACHE_ON) {
+        CalcCache(true);
+    }
+    else if (command == CACHE_OFF) {
+        CalcCache(false);
+    }
     else if (command == SUB) {
         CalcSub(stack, line_number);
     }
@@ -362,6 +471,8 @@ void CalcExecute(Stack *stack, size_t line_number, int command) {
 
 void CalcRun() {
     Stack* stack = StackCreate(DEFAULT_SIZE);
+    PolyProgram program;
+    bool compiled = false;
     ssize_t line_length;
     size_t line_number = 0;
 
@@ -380,6 +491,38 @@ void CalcRun() {
 
                 CalcAt(stack, strtoll(line + 3, &endptr, 10), line_number);
             }
+            else if (command == AT_MANY) {
+                size_t n = 0;
+                poly_coeff_t *xs = ParserValues(line + 7, &n);
+
+                CalcAtMany(stack, xs, n, line_number);
+
+                free(xs);
+            }
+            else if (command == COMPILE) {
+                CalcCompile(stack, &program, &compiled, line_number);
+            }
+            else if (command == RUN) {
+                size_t count = 0;
+                poly_coeff_t *xs = ParserValues(line + 3, &count);
+
+                CalcRunProgram(&program, compiled, xs, count, line_number);
+
+                free(xs);
+            }
+            else if (command == EVAL) {
+                size_t k = 0;
+                poly_coeff_t *x = ParserValues(line + 4, &k);
+
+                CalcEval(stack, x, k, line_number);
+
+                free(x);
+            }
+            else if (command == POW) {
+                char *endptr = NULL;
+
+                CalcPow(stack, strtoull(line + 4, &endptr, 10), line_number);
+            }
             else if (command == DEG_BY) {
                 char *endptr = NULL;
 
@@ -411,6 +554,13 @@ void CalcRun() {
         exit(1);
     }
 
+    if (compiled) {
+        PolyProgramDestroy(&program);
+    }
+
     free(line);
     StackDestroy(stack);
+    PolyCacheClear();
+    PolyScratchFree();
+    PolyPoolTrim();
 }
\ No newline at end of file
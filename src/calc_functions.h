@@ -8,6 +8,7 @@
 #ifndef __CALC_FUNCTIONS_H__
 #define __CALC_FUNCTIONS_H__
 
+#include "poly_program.h"
 #include "stack.h"
 
 /**
@@ -46,6 +47,7 @@ void CalcAdd(Stack *stack, size_t line_number);
 
 /**
  * Mnoży dwa wielomiany z wierzchu stosu, usuwa je i wstawia na wierzchołek stosu ich iloczyn.
+ * Jeżeli wielomiany są równe, podnosi jeden z nich do kwadratu.
  * @param[in, out] stack : stos
  * @param[in] line_number : numer wiersza
  */ 
@@ -58,6 +60,24 @@ void CalcMul(Stack *stack, size_t line_number);
  */ 
 void CalcNeg(Stack *stack, size_t line_number);
 
+/**
+ * Zastępuje wielomian na wierzchołku stosu równym mu wielomianem
+ * internowanym (zob. PolyInternOwn).
+ * @param[in, out] stack : stos
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcIntern(Stack *stack, size_t line_number);
+
+/**
+ * Włącza lub wyłącza pamięć podręczną wyników mnożenia, potęgowania
+ * i składania wielomianów. Domyślnie jest wyłączona, bo wynik zapamiętany
+ * w pamięci podręcznej współdzieli pamięć z wynikiem na stosie, więc
+ * następna operacja w miejscu na tym wyniku musi go najpierw skopiować.
+ * Wyłączenie usuwa zapamiętane wyniki.
+ * @param[in] on : czy włączyć pamięć podręczną
+ */
+void CalcCache(bool on);
+
 /**
  * Odejmuje od wielomianu z wierzchołka wielomian pod wierzchołkiem, usuwa je i wstawia na wierzchołek stosu różnicę.
  * @param[in, out] stack : stos
@@ -65,6 +85,14 @@ void CalcNeg(Stack *stack, size_t line_number);
  */ 
 void CalcSub(Stack *stack, size_t line_number);
 
+/**
+ * Podnosi wielomian z wierzchołka stosu do potęgi @p e, usuwa go i wstawia na wierzchołek stosu wynik.
+ * @param[in, out] stack : stos
+ * @param[in] e : wykładnik
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcPow(Stack *stack, unsigned long long e, size_t line_number);
+
 /**
  * Sprawdza, czy dwa wielomiany na wierzchu stosu są równe.
  * @param[in] stack : stos
@@ -95,6 +123,50 @@ void CalcDegBy(const Stack *stack, unsigned long long idx, size_t line_number);
  */ 
 void CalcAt(Stack *stack, long long x, size_t line_number);
 
+/**
+ * Wylicza wartości wielomianu w punktach @p xs, usuwa wielomian z wierzchołka
+ * i wstawia na stos kolejne wyniki, tak że wynik dla ostatniego punktu
+ * znajduje się na wierzchołku.
+ * @param[in, out] stack : stos
+ * @param[in] xs : punkty, w których chcemy wyliczyć wartości
+ * @param[in] n : liczba punktów
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcAtMany(Stack *stack, const poly_coeff_t xs[], size_t n, size_t line_number);
+
+/**
+ * Wypisuje na standardowe wyjście wartość wielomianu z wierzchołka stosu
+ * w punkcie @f$(x_0, \ldots, x_{k-1}, 0, 0, \ldots)@f$.
+ * @param[in] stack : stos
+ * @param[in] x : wartości kolejnych zmiennych
+ * @param[in] k : liczba wartości
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcEval(const Stack *stack, const poly_coeff_t x[], size_t k, size_t line_number);
+
+/**
+ * Tłumaczy wielomian z wierzchołka stosu na program wyliczający jego wartość
+ * i zapamiętuje go w miejsce poprzedniego. Nie zmienia stosu.
+ * @param[in] stack : stos
+ * @param[in, out] program : zapamiętany program
+ * @param[in, out] compiled : czy @p program zawiera program?
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcCompile(const Stack *stack, PolyProgram *program, bool *compiled, size_t line_number);
+
+/**
+ * Wypisuje na standardowe wyjście wartości zapamiętanego programu w kolejnych
+ * punktach. Wartości @p xs są dzielone na punkty po PolyProgramArity
+ * wartości, więc ich liczba musi być wielokrotnością tej liczby.
+ * @param[in] program : zapamiętany program
+ * @param[in] compiled : czy @p program zawiera program?
+ * @param[in] xs : wartości zmiennych w kolejnych punktach
+ * @param[in] count : liczba wartości
+ * @param[in] line_number : numer wiersza
+ */ 
+void CalcRunProgram(const PolyProgram *program, bool compiled, const poly_coeff_t xs[], size_t count,
+                    size_t line_number);
+
 /**
  * Wypisuje na standardowe wyjście złożenie wielomianu z wierzchu stosu z k kolejnymi wielomianami.
  * @param[in, out] stack : stos
@@ -0,0 +1,588 @@
+/** @file
+  Implementacja mnożenia gęstych wielomianów jednej zmiennej
+
+  Krótkie wielomiany mnożymy szkolnie, dłuższe algorytmem Karatsuby,
+  a najdłuższe za pomocą liczbowej transformaty Fouriera modulo trzy liczby
+  pierwsze mniejsze od @f$2^{62}@f$, z arytmetyką Montgomery'ego.
+  Współczynniki dokładnego iloczynu mieszczą się poniżej iloczynu tych liczb,
+  więc po odtworzeniu ich z reszt wynik modulo @f$2^{64}@f$ jest dokładny.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "dense.h"
+#include "poly_math.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Długość, poniżej której mnożymy szkolnie zamiast algorytmem Karatsuby.
+ */
+#define KARATSUBA_THRESHOLD 32
+
+/**
+ * Liczba liczb pierwszych, modulo które liczymy transformatę.
+ */
+#define NTT_PRIMES_COUNT 3
+
+/**
+ * Koszt jednej operacji motylkowej transformaty wyrażony w mnożeniach
+ * współczynników, używany przy wyborze algorytmu.
+ */
+#define NTT_BUTTERFLY_COST 7
+
+/**
+ * Mnoży szkolnie dwa wielomiany gęste, pomijając zerowe współczynniki @p a.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] r : @f$n + m - 1@f$ współczynników iloczynu
+ */
+static void SchoolbookMul(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, dense_coeff_t *r) {
+    memset(r, 0, (n + m - 1) * sizeof(dense_coeff_t));
+
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] == 0) {
+            continue;
+        }
+
+        for (size_t j = 0; j < m; j++) {
+            r[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+/**
+ * Mnoży algorytmem Karatsuby dwa wielomiany gęste tej samej długości.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] n : liczba współczynników każdego z czynników
+ * @param[out] r : @f$2n - 1@f$ współczynników iloczynu
+ * @param[in] scratch : pamięć pomocnicza na co najmniej @f$6n@f$ współczynników
+ */
+static void KaratsubaMul(const dense_coeff_t *a, const dense_coeff_t *b, size_t n, dense_coeff_t *r,
+                         dense_coeff_t *scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        SchoolbookMul(a, n, b, n, r);
+
+        return;
+    }
+
+    size_t k = n / 2;
+    size_t h = n - k;
+
+    dense_coeff_t *sa = scratch;
+    dense_coeff_t *sb = sa + h;
+    dense_coeff_t *mid = sb + h;
+    dense_coeff_t *rest = mid + 2 * h - 1;
+
+    for (size_t i = 0; i < h; i++) {
+        sa[i] = a[k + i] + (i < k ? a[i] : 0);
+        sb[i] = b[k + i] + (i < k ? b[i] : 0);
+    }
+
+    KaratsubaMul(a, b, k, r, rest);
+    r[2 * k - 1] = 0;
+    KaratsubaMul(a + k, b + k, h, r + 2 * k, rest);
+    KaratsubaMul(sa, sb, h, mid, rest);
+
+    for (size_t i = 0; i < 2 * k - 1; i++) {
+        mid[i] -= r[i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        mid[i] -= r[2 * k + i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        r[k + i] += mid[i];
+    }
+}
+
+/**
+ * Podnosi szkolnie wielomian gęsty do kwadratu, pomijając zerowe współczynniki.
+ * Liczy tylko iloczyny @f$a_i a_j@f$ dla @f$i < j@f$, podwaja je i dodaje
+ * kwadraty @f$a_i^2@f$.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników
+ * @param[out] r : @f$2n - 1@f$ współczynników kwadratu
+ */
+static void SchoolbookSqr(const dense_coeff_t *a, size_t n, dense_coeff_t *r) {
+    memset(r, 0, (2 * n - 1) * sizeof(dense_coeff_t));
+
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] == 0) {
+            continue;
+        }
+
+        for (size_t j = i + 1; j < n; j++) {
+            r[i + j] += a[i] * a[j];
+        }
+    }
+
+    for (size_t i = 0; i < 2 * n - 1; i++) {
+        r[i] *= 2;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        r[2 * i] += a[i] * a[i];
+    }
+}
+
+/**
+ * Podnosi wielomian gęsty do kwadratu algorytmem Karatsuby, czyli przez
+ * trzy kwadraty wielomianów o połowę krótszych.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników
+ * @param[out] r : @f$2n - 1@f$ współczynników kwadratu
+ * @param[in] scratch : pamięć pomocnicza na co najmniej @f$6n@f$ współczynników
+ */
+static void KaratsubaSqr(const dense_coeff_t *a, size_t n, dense_coeff_t *r, dense_coeff_t *scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        SchoolbookSqr(a, n, r);
+
+        return;
+    }
+
+    size_t k = n / 2;
+    size_t h = n - k;
+
+    dense_coeff_t *sa = scratch;
+    dense_coeff_t *mid = sa + h;
+    dense_coeff_t *rest = mid + 2 * h - 1;
+
+    for (size_t i = 0; i < h; i++) {
+        sa[i] = a[k + i] + (i < k ? a[i] : 0);
+    }
+
+    KaratsubaSqr(a, k, r, rest);
+    r[2 * k - 1] = 0;
+    KaratsubaSqr(a + k, h, r + 2 * k, rest);
+    KaratsubaSqr(sa, h, mid, rest);
+
+    for (size_t i = 0; i < 2 * k - 1; i++) {
+        mid[i] -= r[i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        mid[i] -= r[2 * k + i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        r[k + i] += mid[i];
+    }
+}
+
+/**
+ * Mnoży dwa wielomiany gęste, z których pierwszy jest nie dłuższy niż drugi.
+ * Dłuższy czynnik jest dzielony na kawałki długości krótszego, a kawałki
+ * są mnożone algorytmem Karatsuby.
+ * @param[in] a : współczynniki krótszego czynnika
+ * @param[in] n : liczba współczynników krótszego czynnika
+ * @param[in] b : współczynniki dłuższego czynnika
+ * @param[in] m : liczba współczynników dłuższego czynnika
+ * @param[out] r : @f$n + m - 1@f$ współczynników iloczynu
+ */
+static void BalancedMul(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, dense_coeff_t *r) {
+    memset(r, 0, (n + m - 1) * sizeof(dense_coeff_t));
+
+    dense_coeff_t *buffer = malloc(9 * n * sizeof(dense_coeff_t));
+    CHECK_PTR(buffer);
+    dense_coeff_t *y = buffer;
+    dense_coeff_t *z = y + n;
+
+    for (size_t j = 0; j < m; j += n) {
+        size_t len = MIN(n, m - j);
+
+        memcpy(y, b + j, len * sizeof(dense_coeff_t));
+        memset(y + len, 0, (n - len) * sizeof(dense_coeff_t));
+
+        KaratsubaMul(a, y, n, z, z + 2 * n);
+
+        for (size_t i = 0; i < n + len - 1; i++) {
+            r[j + i] += z[i];
+        }
+    }
+
+    free(buffer);
+}
+
+/**
+ * Moduł, w którym liczymy transformatę, wraz ze stałymi arytmetyki
+ * Montgomery'ego. Liczby w postaci Montgomery'ego to reszty pomnożone
+ * przez @f$R = 2^{64}@f$.
+ */
+typedef struct NttModulus {
+    dense_coeff_t p; ///< liczba pierwsza postaci @f$c \cdot 2^k + 1@f$ mniejsza od @f$2^{62}@f$
+    dense_coeff_t root; ///< pierwiastek pierwotny modulo @p p
+    dense_coeff_t inverse; ///< @f$-p^{-1} \bmod R@f$
+    dense_coeff_t r2; ///< @f$R^2 \bmod p@f$
+} NttModulus;
+
+/**
+ * Liczby pierwsze używane w transformacie, posortowane rosnąco.
+ * Każda z nich pozwala na transformaty długości do @f$2^{38}@f$.
+ */
+static const dense_coeff_t NTT_PRIMES[NTT_PRIMES_COUNT][2] = {
+    {0x3FFF810000000001ul, 5},
+    {0x3FFFCA8000000001ul, 7},
+    {0x3FFFF3C000000001ul, 14},
+};
+
+/**
+ * Mnoży dwie liczby w arytmetyce Montgomery'ego.
+ * @param[in] mod : moduł
+ * @param[in] x : liczba mniejsza od @f$2p@f$
+ * @param[in] y : liczba mniejsza od @f$p@f$
+ * @return @f$xyR^{-1} \bmod p@f$
+ */
+static inline dense_coeff_t MontgomeryMul(const NttModulus *mod, dense_coeff_t x, dense_coeff_t y) {
+    unsigned __int128 t = (unsigned __int128)x * y;
+    dense_coeff_t q = (dense_coeff_t)t * mod->inverse;
+    dense_coeff_t u = (dense_coeff_t)((t + (unsigned __int128)q * mod->p) >> 64);
+
+    return u >= mod->p ? u - mod->p : u;
+}
+
+/**
+ * Zamienia resztę na postać Montgomery'ego.
+ * @param[in] mod : moduł
+ * @param[in] x : liczba
+ * @return @f$xR \bmod p@f$
+ */
+static dense_coeff_t MontgomeryFrom(const NttModulus *mod, dense_coeff_t x) {
+    return MontgomeryMul(mod, x % mod->p, mod->r2);
+}
+
+/**
+ * Podnosi do potęgi liczbę w postaci Montgomery'ego.
+ * @param[in] mod : moduł
+ * @param[in] x : podstawa w postaci Montgomery'ego
+ * @param[in] e : wykładnik
+ * @return @f$x^e@f$ w postaci Montgomery'ego
+ */
+static dense_coeff_t MontgomeryPow(const NttModulus *mod, dense_coeff_t x, dense_coeff_t e) {
+    dense_coeff_t result = MontgomeryFrom(mod, 1);
+
+    while (e > 0) {
+        if (e & 1) {
+            result = MontgomeryMul(mod, result, x);
+        }
+        x = MontgomeryMul(mod, x, x);
+        e >>= 1;
+    }
+
+    return result;
+}
+
+/**
+ * Liczy stałe arytmetyki Montgomery'ego dla jednej z liczb NTT_PRIMES.
+ * @param[in] index : indeks liczby pierwszej
+ * @return moduł
+ */
+static NttModulus NttModulusGet(size_t index) {
+    NttModulus mod;
+    mod.p = NTT_PRIMES[index][0];
+    mod.root = NTT_PRIMES[index][1];
+
+    // Iteracja Newtona podwaja liczbę poprawnych bitów odwrotności, a p jest
+    // swoją odwrotnością modulo 8.
+    dense_coeff_t inverse = mod.p;
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - mod.p * inverse;
+    }
+    mod.inverse = -inverse;
+
+    unsigned __int128 r = ((unsigned __int128)1 << 64) % mod.p;
+    mod.r2 = (dense_coeff_t)(r * r % mod.p);
+
+    return mod;
+}
+
+/**
+ * Liczy w miejscu transformatę (wariant Gentlemana-Sande'a). Wynik jest
+ * w kolejności odwróconych bitów indeksów.
+ * @param[in,out] a : reszty, mniejsze od @f$p@f$
+ * @param[in] len : długość transformaty (potęga dwójki)
+ * @param[in] mod : moduł
+ * @param[in] roots : potęgi pierwiastka stopnia @p len z jedynki
+ * w postaci Montgomery'ego, @f$len / 2@f$ kolejnych
+ */
+static void NttForward(dense_coeff_t *a, size_t len, const NttModulus *mod, const dense_coeff_t *roots) {
+    dense_coeff_t p = mod->p;
+
+    for (size_t half = len / 2, step = 1; half > 0; half /= 2, step *= 2) {
+        for (size_t i = 0; i < len; i += 2 * half) {
+            for (size_t j = 0; j < half; j++) {
+                dense_coeff_t u = a[i + j];
+                dense_coeff_t v = a[i + j + half];
+                dense_coeff_t sum = u + v;
+
+                a[i + j] = sum >= p ? sum - p : sum;
+                a[i + j + half] = MontgomeryMul(mod, u + p - v, roots[j * step]);
+            }
+        }
+    }
+}
+
+/**
+ * Liczy w miejscu transformatę odwrotną (wariant Cooleya-Tukeya) bez
+ * dzielenia przez długość. Dane wejściowe są w kolejności odwróconych bitów
+ * indeksów, a wynik w zwykłej.
+ * @param[in,out] a : reszty, mniejsze od @f$p@f$
+ * @param[in] len : długość transformaty (potęga dwójki)
+ * @param[in] mod : moduł
+ * @param[in] roots : potęgi odwrotności pierwiastka stopnia @p len z jedynki
+ * w postaci Montgomery'ego, @f$len / 2@f$ kolejnych
+ */
+static void NttInverse(dense_coeff_t *a, size_t len, const NttModulus *mod, const dense_coeff_t *roots) {
+    dense_coeff_t p = mod->p;
+
+    for (size_t half = 1, step = len / 2; half < len; half *= 2, step /= 2) {
+        for (size_t i = 0; i < len; i += 2 * half) {
+            for (size_t j = 0; j < half; j++) {
+                dense_coeff_t u = a[i + j];
+                dense_coeff_t v = MontgomeryMul(mod, a[i + j + half], roots[j * step]);
+                dense_coeff_t sum = u + v;
+
+                a[i + j] = sum >= p ? sum - p : sum;
+                a[i + j + half] = u >= v ? u - v : u + p - v;
+            }
+        }
+    }
+}
+
+/**
+ * Liczy iloczyn modulo jedna z liczb NTT_PRIMES.
+ * Reszty nie są zamieniane na postać Montgomery'ego: mnożenia przez
+ * pierwiastki z jedynki tego nie wymagają, a czynnik @f$R^{-1}@f$
+ * z mnożenia transformat jest kompensowany przy dzieleniu przez długość.
+ * Gdy @p b jest tą samą tablicą co @p a, liczy tylko jedną transformatę
+ * i podnosi ją do kwadratu.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[in] len : długość transformaty, nie mniejsza niż @f$n + m - 1@f$
+ * @param[in] mod : moduł
+ * @param[out] r : @p len współczynników iloczynu modulo @f$p@f$
+ * @param[in] scratch : pamięć pomocnicza na @f$2 \cdot len@f$ liczb
+ */
+static void NttMulModulo(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, size_t len,
+                         const NttModulus *mod, dense_coeff_t *r, dense_coeff_t *scratch) {
+    dense_coeff_t *y = scratch;
+    dense_coeff_t *roots = y + len;
+    dense_coeff_t *inverse_roots = roots + len / 2;
+
+    dense_coeff_t root = MontgomeryPow(mod, MontgomeryFrom(mod, mod->root), (mod->p - 1) / len);
+    dense_coeff_t inverse_root = MontgomeryPow(mod, root, mod->p - 2);
+
+    roots[0] = inverse_roots[0] = MontgomeryFrom(mod, 1);
+    for (size_t i = 1; i < len / 2; i++) {
+        roots[i] = MontgomeryMul(mod, roots[i - 1], root);
+        inverse_roots[i] = MontgomeryMul(mod, inverse_roots[i - 1], inverse_root);
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        r[i] = i < n ? a[i] % mod->p : 0;
+    }
+    NttForward(r, len, mod, roots);
+
+    if (a == b && n == m) {
+        for (size_t i = 0; i < len; i++) {
+            r[i] = MontgomeryMul(mod, r[i], r[i]);
+        }
+    }
+    else {
+        for (size_t i = 0; i < len; i++) {
+            y[i] = i < m ? b[i] % mod->p : 0;
+        }
+        NttForward(y, len, mod, roots);
+
+        for (size_t i = 0; i < len; i++) {
+            r[i] = MontgomeryMul(mod, r[i], y[i]);
+        }
+    }
+    NttInverse(r, len, mod, inverse_roots);
+
+    // MontgomeryMul(x, len^{-1} R^2) = x len^{-1} R.
+    dense_coeff_t scale = MontgomeryPow(mod, MontgomeryFrom(mod, len), mod->p - 2);
+    scale = MontgomeryMul(mod, scale, mod->r2);
+    for (size_t i = 0; i < n + m - 1; i++) {
+        r[i] = MontgomeryMul(mod, r[i], scale);
+    }
+}
+
+/**
+ * Mnoży dwa wielomiany gęste za pomocą transformaty Fouriera modulo
+ * trzy liczby pierwsze. Współczynniki traktujemy jako liczby naturalne
+ * mniejsze od @f$2^{64}@f$, więc współczynniki dokładnego iloczynu są
+ * mniejsze od @f$\min(n, m) \cdot 2^{128}@f$, czyli od iloczynu liczb pierwszych.
+ * Odtwarzamy je algorytmem Garnera, a ostatni krok liczymy już modulo
+ * @f$2^{64}@f$.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] r : @f$n + m - 1@f$ współczynników iloczynu
+ */
+static void NttMul(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, dense_coeff_t *r) {
+    size_t len = 1;
+    while (len < n + m - 1) {
+        len *= 2;
+    }
+
+    dense_coeff_t *buffer = malloc((NTT_PRIMES_COUNT + 2) * len * sizeof(dense_coeff_t));
+    CHECK_PTR(buffer);
+
+    NttModulus mod[NTT_PRIMES_COUNT];
+    dense_coeff_t *residues[NTT_PRIMES_COUNT];
+    for (size_t i = 0; i < NTT_PRIMES_COUNT; i++) {
+        mod[i] = NttModulusGet(i);
+        residues[i] = buffer + i * len;
+        NttMulModulo(a, n, b, m, len, &mod[i], residues[i], buffer + NTT_PRIMES_COUNT * len);
+    }
+
+    dense_coeff_t p0 = mod[0].p;
+    dense_coeff_t p1 = mod[1].p;
+    dense_coeff_t p2 = mod[2].p;
+    // Stałe w postaci Montgomery'ego.
+    dense_coeff_t p0_inverse_1 = MontgomeryPow(&mod[1], MontgomeryFrom(&mod[1], p0), p1 - 2);
+    dense_coeff_t p0_2 = MontgomeryFrom(&mod[2], p0);
+    dense_coeff_t p0p1_inverse_2 = MontgomeryPow(&mod[2], MontgomeryMul(&mod[2], p0_2, MontgomeryFrom(&mod[2], p1)),
+                                                 p2 - 2);
+
+    for (size_t i = 0; i < n + m - 1; i++) {
+        dense_coeff_t x0 = residues[0][i];
+        dense_coeff_t x1 = MontgomeryMul(&mod[1], residues[1][i] + p1 - x0, p0_inverse_1);
+        dense_coeff_t x2 = residues[2][i] + p2 - x0;
+
+        x2 = x2 >= p2 ? x2 - p2 : x2;
+        x2 = x2 + p2 - MontgomeryMul(&mod[2], x1, p0_2);
+        x2 = MontgomeryMul(&mod[2], x2, p0p1_inverse_2);
+
+        r[i] = x0 + p0 * x1 + p0 * p1 * x2;
+    }
+
+    free(buffer);
+}
+
+/**
+ * Liczy niezerowe współczynniki wielomianu gęstego.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników
+ * @return liczba niezerowych współczynników
+ */
+static size_t CountNonZero(const dense_coeff_t *a, size_t n) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        count += (a[i] != 0);
+    }
+
+    return count;
+}
+
+/**
+ * Szacuje liczbę mnożeń potrzebnych funkcji BalancedMul.
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @return przybliżona liczba mnożeń
+ */
+static double BalancedMulWork(size_t n, size_t m) {
+    size_t shorter = MIN(n, m);
+    double chunks = (double)MAX(n, m) / shorter + 1;
+    double work = (double)KARATSUBA_THRESHOLD * KARATSUBA_THRESHOLD;
+
+    for (size_t len = KARATSUBA_THRESHOLD; len < shorter; len *= 2) {
+        work *= 3;
+    }
+
+    return chunks * work;
+}
+
+/**
+ * Szacuje liczbę mnożeń potrzebnych funkcji NttMul, licząc każdą
+ * operację motylkową jako NTT_BUTTERFLY_COST mnożeń.
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @return przybliżona liczba mnożeń
+ */
+static double NttMulWork(size_t n, size_t m) {
+    size_t len = 1;
+    size_t levels = 0;
+
+    while (len < n + m - 1) {
+        len *= 2;
+        levels++;
+    }
+
+    return (double)NTT_PRIMES_COUNT * 3 * (len / 2) * levels * NTT_BUTTERFLY_COST;
+}
+
+double DenseMulWork(size_t n, size_t nonzero_a, size_t m, size_t nonzero_b) {
+    double schoolbook = MIN((double)nonzero_a * m, (double)nonzero_b * n);
+
+    if (MIN(n, m) < KARATSUBA_THRESHOLD) {
+        return schoolbook;
+    }
+
+    return MIN(schoolbook, MIN(BalancedMulWork(n, m), NttMulWork(n, m)));
+}
+
+void DenseMul(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, dense_coeff_t *r) {
+    size_t nonzero_a = CountNonZero(a, n);
+    size_t nonzero_b = CountNonZero(b, m);
+    double schoolbook_a = (double)nonzero_a * m;
+    double schoolbook_b = (double)nonzero_b * n;
+    double work = DenseMulWork(n, nonzero_a, m, nonzero_b);
+
+    if (work >= MIN(schoolbook_a, schoolbook_b)) {
+        if (schoolbook_a <= schoolbook_b) {
+            SchoolbookMul(a, n, b, m, r);
+        }
+        else {
+            SchoolbookMul(b, m, a, n, r);
+        }
+    }
+    else if (work >= NttMulWork(n, m)) {
+        NttMul(a, n, b, m, r);
+    }
+    else if (n <= m) {
+        BalancedMul(a, n, b, m, r);
+    }
+    else {
+        BalancedMul(b, m, a, n, r);
+    }
+}
+
+double DenseSqrWork(size_t n, size_t nonzero) {
+    double schoolbook = (double)nonzero * n / 2;
+
+    if (n < KARATSUBA_THRESHOLD) {
+        return schoolbook;
+    }
+
+    return MIN(schoolbook, MIN(BalancedMulWork(n, n) / 2, NttMulWork(n, n) * 2 / 3));
+}
+
+void DenseSqr(const dense_coeff_t *a, size_t n, dense_coeff_t *r) {
+    size_t nonzero = CountNonZero(a, n);
+    double schoolbook = (double)nonzero * n / 2;
+    double work = DenseSqrWork(n, nonzero);
+
+    if (work >= schoolbook) {
+        SchoolbookSqr(a, n, r);
+    }
+    else if (work >= NttMulWork(n, n) * 2 / 3) {
+        NttMul(a, n, a, n, r);
+    }
+    else {
+        dense_coeff_t *scratch = malloc(6 * n * sizeof(dense_coeff_t));
+        CHECK_PTR(scratch);
+
+        KaratsubaSqr(a, n, r, scratch);
+
+        free(scratch);
+    }
+}
@@ -0,0 +1,67 @@
+/** @file
+  Interfejs mnożenia gęstych wielomianów jednej zmiennej
+
+  Wielomian gęsty to tablica kolejnych współczynników (indeks jest
+  wykładnikiem). Arytmetyka odbywa się modulo @f$2^{64}@f$, czyli daje te same
+  wyniki, co operacje na typie poly_coeff_t z zawijaniem przy przepełnieniu.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __DENSE_H__
+#define __DENSE_H__
+
+#include <stddef.h>
+
+/** To jest typ współczynników wielomianów gęstych. */
+typedef unsigned long dense_coeff_t;
+
+/**
+ * Szacuje liczbę mnożeń współczynników potrzebnych funkcji DenseMul.
+ * Pozwala zdecydować, czy opłaca się zamienić wielomiany rzadkie na gęste.
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] nonzero_a : liczba niezerowych współczynników pierwszego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[in] nonzero_b : liczba niezerowych współczynników drugiego czynnika
+ * @return przybliżona liczba mnożeń
+ */
+double DenseMulWork(size_t n, size_t nonzero_a, size_t m, size_t nonzero_b);
+
+/**
+ * Mnoży dwa wielomiany gęste.
+ * W zależności od długości i wypełnienia czynników używa mnożenia szkolnego
+ * (pomijającego zerowe współczynniki), algorytmu Karatsuby lub transformaty
+ * Fouriera modulo liczby pierwsze.
+ * Tablica @p r musi mieć miejsce na @f$n + m - 1@f$ współczynników
+ * i nie może pokrywać się z @p a ani z @p b.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika (dodatnia)
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika (dodatnia)
+ * @param[out] r : współczynniki iloczynu
+ */
+void DenseMul(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m, dense_coeff_t *r);
+
+/**
+ * Szacuje liczbę mnożeń współczynników potrzebnych funkcji DenseSqr.
+ * @param[in] n : liczba współczynników
+ * @param[in] nonzero : liczba niezerowych współczynników
+ * @return przybliżona liczba mnożeń
+ */
+double DenseSqrWork(size_t n, size_t nonzero);
+
+/**
+ * Podnosi wielomian gęsty do kwadratu. Iloczyny różnych współczynników są
+ * liczone raz i podwajane, algorytm Karatsuby potrzebuje trzech kwadratów
+ * zamiast trzech iloczynów, a transformata Fouriera jest liczona raz
+ * zamiast dwóch razy.
+ * Tablica @p r musi mieć miejsce na @f$2n - 1@f$ współczynników
+ * i nie może pokrywać się z @p a.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników (dodatnia)
+ * @param[out] r : współczynniki kwadratu
+ */
+void DenseSqr(const dense_coeff_t *a, size_t n, dense_coeff_t *r);
+
+#endif /* __DENSE_H__ */
@@ -0,0 +1,327 @@
+/** @file
+  Implementacja sortowania tablic jednomianów względem wykładników
+
+  Sortowanie pozycyjne przetwarza klucze bajt po bajcie, zaczynając od
+  najmłodszego. Klucz to wykładnik z zanegowanym bitem znaku, dzięki czemu
+  porządek kluczy bez znaku zgadza się z porządkiem wykładników. Przebiegi,
+  w których wszystkie klucze mają ten sam bajt, są pomijane, więc dla
+  typowych, małych wykładników wykonujemy jeden lub dwa przebiegi.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "mono_sort.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PARALLEL_SORT
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Długość, poniżej której sortujemy przez wstawianie.
+ */
+#define INSERTION_SORT_THRESHOLD 32
+
+/**
+ * Liczba bitów klucza przetwarzanych w jednym przebiegu.
+ */
+#define RADIX_BITS 8
+
+/**
+ * Liczba kubełków w jednym przebiegu.
+ */
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/**
+ * Liczba przebiegów potrzebna do przetworzenia całego klucza.
+ */
+#define RADIX_PASSES ((int)(sizeof(uint32_t) * 8 / RADIX_BITS))
+
+#ifdef PARALLEL_SORT
+/**
+ * Długość, od której sortujemy wielowątkowo.
+ */
+#define PARALLEL_SORT_THRESHOLD (1 << 20)
+
+/**
+ * Maksymalna liczba wątków sortujących.
+ */
+#define PARALLEL_SORT_MAX_THREADS 8
+#endif
+
+/**
+ * Zwraca klucz sortowania jednomianu.
+ * @param[in] m : jednomian
+ * @return wykładnik jako liczba bez znaku zachowująca porządek
+ */
+static inline uint32_t MonoKey(const Mono *m) {
+    return (uint32_t)MonoGetExp(m) ^ ((uint32_t)1 << 31);
+}
+
+/**
+ * Zwraca bajt klucza sortowania jednomianu.
+ * @param[in] m : jednomian
+ * @param[in] pass : numer przebiegu (numer bajtu, licząc od najmłodszego)
+ * @return bajt klucza
+ */
+static inline size_t MonoDigit(const Mono *m, int pass) {
+    return (MonoKey(m) >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+/**
+ * Sortuje stabilnie tablicę jednomianów przez wstawianie.
+ * @param[in] count : liczba jednomianów
+ * @param[in, out] monos : tablica jednomianów
+ */
+static void InsertionSort(size_t count, Mono monos[]) {
+    for (size_t i = 1; i < count; i++) {
+        Mono m = monos[i];
+        size_t j = i;
+
+        while (j > 0 && MonoGetExp(&monos[j - 1]) > MonoGetExp(&m)) {
+            monos[j] = monos[j - 1];
+            j--;
+        }
+
+        monos[j] = m;
+    }
+}
+
+/**
+ * Zamienia liczby jednomianów w kubełkach na pozycje początków kubełków.
+ * @param[in, out] histogram : liczby jednomianów w kolejnych kubełkach
+ * @param[in] count : liczba wszystkich jednomianów
+ * @return czy przebieg jest potrzebny (czy jednomiany trafiają do co najmniej
+ * dwóch kubełków)?
+ */
+static bool RadixPrefixSums(size_t histogram[], size_t count) {
+    size_t sum = 0;
+
+    for (size_t b = 0; b < RADIX_BUCKETS; b++) {
+        if (histogram[b] == count) {
+            return false;
+        }
+
+        size_t c = histogram[b];
+        histogram[b] = sum;
+        sum += c;
+    }
+
+    return true;
+}
+
+/**
+ * Sortuje pozycyjnie tablicę jednomianów w jednym wątku.
+ * @param[in] count : liczba jednomianów
+ * @param[in, out] monos : tablica jednomianów
+ * @param[in] buffer : pamięć pomocnicza na @p count jednomianów
+ */
+static void RadixSort(size_t count, Mono monos[], Mono buffer[]) {
+    size_t histogram[RADIX_PASSES][RADIX_BUCKETS] = {{0}};
+
+    for (size_t i = 0; i < count; i++) {
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            histogram[pass][MonoDigit(&monos[i], pass)]++;
+        }
+    }
+
+    Mono *src = monos;
+    Mono *dst = buffer;
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        if (!RadixPrefixSums(histogram[pass], count)) {
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            dst[histogram[pass][MonoDigit(&src[i], pass)]++] = src[i];
+        }
+
+        Mono *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != monos) {
+        memcpy(monos, src, count * sizeof(Mono));
+    }
+}
+
+#ifdef PARALLEL_SORT
+/**
+ * Fragment tablicy przetwarzany przez jeden wątek w jednym przebiegu.
+ */
+typedef struct RadixTask {
+    const Mono *src; ///< tablica źródłowa
+    Mono *dst; ///< tablica docelowa
+    size_t begin; ///< początek fragmentu
+    size_t end; ///< koniec fragmentu
+    int pass; ///< numer przebiegu
+    size_t histogram[RADIX_BUCKETS]; ///< liczby jednomianów lub pozycje w kubełkach
+} RadixTask;
+
+/**
+ * Liczy histogram bajtów kluczy we fragmencie tablicy.
+ * @param[in, out] arg : wskaźnik na RadixTask
+ * @return NULL
+ */
+static void* RadixCount(void *arg) {
+    RadixTask *task = arg;
+
+    memset(task->histogram, 0, sizeof(task->histogram));
+    for (size_t i = task->begin; i < task->end; i++) {
+        task->histogram[MonoDigit(&task->src[i], task->pass)]++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Rozrzuca jednomiany fragmentu tablicy do kubełków.
+ * @param[in, out] arg : wskaźnik na RadixTask z pozycjami w kubełkach
+ * @return NULL
+ */
+static void* RadixScatter(void *arg) {
+    RadixTask *task = arg;
+
+    for (size_t i = task->begin; i < task->end; i++) {
+        task->dst[task->histogram[MonoDigit(&task->src[i], task->pass)]++] = task->src[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * Uruchamia funkcję dla każdego zadania w osobnym wątku i czeka na ich koniec.
+ * @param[in] routine : funkcja
+ * @param[in, out] tasks : zadania
+ * @param[in] threads : liczba zadań
+ */
+static void RunThreads(void* (*routine)(void*), RadixTask tasks[], size_t threads) {
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    CHECK_PTR(ids);
+
+    for (size_t t = 0; t < threads; t++) {
+        if (pthread_create(&ids[t], NULL, routine, &tasks[t]) != 0) {
+            exit(1);
+        }
+    }
+
+    for (size_t t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+
+    free(ids);
+}
+
+/**
+ * Sortuje pozycyjnie tablicę jednomianów wielowątkowo. W każdym przebiegu
+ * wątki liczą histogramy swoich fragmentów, a potem każdy rozrzuca swój
+ * fragment do własnych części kubełków, co zachowuje stabilność.
+ * @param[in] count : liczba jednomianów
+ * @param[in, out] monos : tablica jednomianów
+ * @param[in] buffer : pamięć pomocnicza na @p count jednomianów
+ * @param[in] threads : liczba wątków
+ */
+static void ParallelRadixSort(size_t count, Mono monos[], Mono buffer[], size_t threads) {
+    RadixTask *tasks = malloc(threads * sizeof(RadixTask));
+    CHECK_PTR(tasks);
+
+    Mono *src = monos;
+    Mono *dst = buffer;
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        for (size_t t = 0; t < threads; t++) {
+            tasks[t].src = src;
+            tasks[t].dst = dst;
+            tasks[t].begin = count * t / threads;
+            tasks[t].end = count * (t + 1) / threads;
+            tasks[t].pass = pass;
+        }
+
+        RunThreads(RadixCount, tasks, threads);
+
+        size_t sum = 0;
+        bool trivial = false;
+        for (size_t b = 0; b < RADIX_BUCKETS && !trivial; b++) {
+            size_t bucket = 0;
+
+            for (size_t t = 0; t < threads; t++) {
+                size_t c = tasks[t].histogram[b];
+                tasks[t].histogram[b] = sum;
+                sum += c;
+                bucket += c;
+            }
+
+            trivial = (bucket == count);
+        }
+
+        if (trivial) {
+            continue;
+        }
+
+        RunThreads(RadixScatter, tasks, threads);
+
+        Mono *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != monos) {
+        memcpy(monos, src, count * sizeof(Mono));
+    }
+
+    free(tasks);
+}
+#endif
+
+void MonosSort(size_t count, Mono monos[]) {
+    bool ascending = true;
+    bool descending = true;
+
+    for (size_t i = 1; i < count && (ascending || descending); i++) {
+        ascending &= MonoGetExp(&monos[i - 1]) <= MonoGetExp(&monos[i]);
+        descending &= MonoGetExp(&monos[i - 1]) > MonoGetExp(&monos[i]);
+    }
+
+    if (ascending) {
+        return;
+    }
+    else if (descending) {
+        for (size_t i = 0, j = count - 1; i < j; i++, j--) {
+            Mono t = monos[i];
+            monos[i] = monos[j];
+            monos[j] = t;
+        }
+
+        return;
+    }
+    else if (count < INSERTION_SORT_THRESHOLD) {
+        InsertionSort(count, monos);
+
+        return;
+    }
+
+    Mono *buffer = malloc(count * sizeof(Mono));
+    CHECK_PTR(buffer);
+
+#ifdef PARALLEL_SORT
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count >= PARALLEL_SORT_THRESHOLD && cpus > 1) {
+        ParallelRadixSort(count, monos, buffer, cpus < PARALLEL_SORT_MAX_THREADS ? cpus : PARALLEL_SORT_MAX_THREADS);
+    }
+    else {
+        RadixSort(count, monos, buffer);
+    }
+#else
+    RadixSort(count, monos, buffer);
+#endif
+
+    free(buffer);
+}
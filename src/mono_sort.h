@@ -0,0 +1,24 @@
+/** @file
+  Interfejs sortowania tablic jednomianów względem wykładników
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __MONO_SORT_H__
+#define __MONO_SORT_H__
+
+#include "poly.h"
+
+/**
+ * Sortuje stabilnie tablicę jednomianów niemalejąco względem wykładników.
+ * Tablice już posortowane (także malejąco) rozpoznaje w jednym przejściu,
+ * krótkie sortuje przez wstawianie, a pozostałe sortuje pozycyjnie (LSD)
+ * po bajtach wykładników. Jeżeli program skompilowano z opcją PARALLEL_SORT,
+ * bardzo duże tablice są sortowane wielowątkowo.
+ * @param[in] count : liczba jednomianów
+ * @param[in, out] monos : tablica jednomianów
+ */
+void MonosSort(size_t count, Mono monos[]);
+
+#endif /* __MONO_SORT_H__ */
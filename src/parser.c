@@ -136,6 +136,60 @@ static int ParserCommandDegBy(const char *line, size_t line_length, size_t line_
     }
 }
 
+/**
+ * Rozpoznaje, czy wiersza zawiera poprawną komendę POW.
+ * Jeżeli wiersz nie zawiera poprawnej komendy, wypisuje odpowiedni komunikat na stderr.
+ * Zakłada, że pierwsze 3 znaki wiersza to "POW".
+ * @param[in] line : wiersz
+ * @param[in] line_length : długość wiersza
+ * @param[in] line_number : number wiersza
+ * @return -1, jeżeli wiersz nie zawierał poprawnej komendy
+ * @return symbol POW, jeżeli wiersza zawierał poprawną komendę
+ */ 
+static int ParserCommandPow(const char *line, size_t line_length, size_t line_number) {
+    if ((line_length == 3) || (line_length == 4 && (line[3] == ' ' || line[3] == '\n')) 
+        || (line_length >= 4 && line[3] == TAB)) {
+        fprintf(stderr, "ERROR %ld POW WRONG EXPONENT\n", line_number);
+
+        return -1;    
+    }
+    else if (line_length >= 5 && line[3] == ' ') {
+        bool valid_line = true;
+
+        valid_line &= !(line[4] == '\n');
+        for (size_t i = 4; i < line_length - 1; i++) {
+            valid_line &= DIGIT(line[i]);
+        }
+        valid_line &= DIGIT(line[line_length - 1]) || (line[line_length - 1] == '\n');
+
+        if (!valid_line) {
+            fprintf(stderr, "ERROR %ld POW WRONG EXPONENT\n", line_number);
+
+            return -1;
+        }
+        else {
+            char *end = NULL;
+            errno = 0;
+
+            unsigned long long e = strtoull(line + 4, &end, 10);
+
+            if (!errno && e <= INT_MAX) {
+                return POW;
+            }
+            else {
+                fprintf(stderr, "ERROR %ld POW WRONG EXPONENT\n", line_number);
+                
+                return -1;
+            }
+        }
+    }
+    else {
+        fprintf(stderr, "ERROR %ld WRONG COMMAND\n", line_number);
+        
+        return -1;
+    }
+}
+
 /**
  * Rozpoznaje, czy wiersza zawiera poprawną komendę COMPOSE.
  * Jeżeli wiersz nie zawiera poprawnej komendy, wypisuje odpowiedni komunikat na stderr.
@@ -190,6 +244,64 @@ static int ParserCommandCompose(const char *line, size_t line_length, size_t lin
     }
 }
 
+/**
+ * Rozpoznaje, czy wiersz zawiera poprawną komendę z listą wartości
+ * oddzielonych pojedynczymi spacjami, np. AT_MANY.
+ * Jeżeli wiersz nie zawiera poprawnej komendy, wypisuje odpowiedni komunikat na stderr.
+ * Zakłada, że wiersz zaczyna się od nazwy komendy @p name.
+ * @param[in] line : wiersz
+ * @param[in] line_length : długość wiersza
+ * @param[in] line_number : number wiersza
+ * @param[in] name : nazwa komendy
+ * @param[in] command : symbol komendy
+ * @return -1, jeżeli wiersz nie zawierał poprawnej komendy
+ * @return @p command, jeżeli wiersza zawierał poprawną komendę
+ */ 
+static int ParserCommandValues(const char *line, size_t line_length, size_t line_number,
+                               const char *name, int command) {
+    size_t i = strlen(name);
+
+    if (line_length > i && line[i] != ' ' && line[i] != TAB && line[i] != '\n') {
+        fprintf(stderr, "ERROR %ld WRONG COMMAND\n", line_number);
+
+        return -1;
+    }
+
+    bool valid_line = line_length > i && line[i] != '\n';
+
+    while (valid_line && i < line_length && line[i] != '\n') {
+        valid_line &= line[i] == ' ';
+        i++;
+
+        size_t begin = i;
+        if (i < line_length && line[i] == '-') {
+            i++;
+        }
+
+        valid_line &= i < line_length && DIGIT(line[i]);
+        while (i < line_length && DIGIT(line[i])) {
+            i++;
+        }
+
+        if (valid_line) {
+            char *end = NULL;
+            errno = 0;
+
+            strtoll(line + begin, &end, 10);
+
+            valid_line &= !errno;
+        }
+    }
+
+    if (!valid_line) {
+        fprintf(stderr, "ERROR %ld %s WRONG VALUE\n", line_number, name);
+
+        return -1;
+    }
+
+    return command;
+}
+
 /**
  * Sprawdza, czy wiersz zawiera poprawne wyrażenie nawiasowe.
  * Sprawdza, czy wiersz nie zawiera jawnie błędnych podciągów.
@@ -276,17 +388,17 @@ static bool ParserValidConst(const char *line, size_t line_length) {
 static Poly ParserPolyAux(const char *line, size_t line_length, size_t line_number, bool *valid, bool write);
 
 /**
- * Sprawdza, czy wiersz zawiera poprawny wielomian.
+ * Sprawdza, czy wiersz zawiera poprawny jednomian.
  * Zakładamy, że wiersz jest postaci "(...)".
  * @param[in] line : wiersz
  * @param[in] line_length : długość wiersza
  * @param[in] line_number : numer wiersza
  * @param[in, out] valid : wskaźnik na zmienną przechowującą informacje, czy wiersz był poprawny
  * @param[in] write : czy wypisywać informacje o błędach?
- * @return wielomian z wiersza, jeżeli wiersz zawierał poprawny wielomian
- * @return wielomian zerowy i ustawienie @p valid na false, jeżeli wiersz nie zawierał wielomianu
+ * @return jednomian z wiersza, jeżeli wiersz zawierał poprawny jednomian
+ * @return jednomian zerowy i ustawienie @p valid na false, jeżeli wiersz nie zawierał jednomianu
  */ 
-static Poly ParserMono(const char *line, size_t line_length, size_t line_number, bool *valid, bool write) {
+static Mono ParserMono(const char *line, size_t line_length, size_t line_number, bool *valid, bool write) {
     for (size_t i = line_length - 1; i > 0; i--) {
         if (line[i] == ',') {
             for (size_t j = i + 1; j < line_length - 1; j++) {
@@ -305,28 +417,13 @@ static Poly ParserMono(const char *line, size_t line_length, size_t line_number,
 
                 *valid = false;
 
-                return PolyZero();
+                return (Mono) {.p = PolyZero(), .exp = 0};
             }
             else {
                 Poly p = ParserPolyAux(line + 1, i - 1, line_number, valid, false);
 
                 if (*valid) {
-                    if (PolyIsZero(&p)) {
-                        return PolyZero();
-                    }
-                    else if (PolyIsCoeff(&p) && exp == 0) {
-                        return p;
-                    }
-                    else {
-                        Mono *m = malloc(sizeof(Mono));
-                        CHECK_PTR(m);
-                
-                        m[0] = (Mono) {.p = p, .exp = exp};
-
-                        Poly r = (Poly) {.arr = m, .size = 1};
-
-                        return r;
-                    }
+                    return (Mono) {.p = p, .exp = exp};
                 }
                 else {
                     if (write) {
@@ -335,7 +432,7 @@ static Poly ParserMono(const char *line, size_t line_length, size_t line_number,
 
                     *valid = false;
 
-                    return PolyZero();
+                    return (Mono) {.p = PolyZero(), .exp = 0};
                 }
             }
 
@@ -348,7 +445,7 @@ static Poly ParserMono(const char *line, size_t line_length, size_t line_number,
 
     *valid = false;
 
-    return PolyZero();
+    return (Mono) {.p = PolyZero(), .exp = 0};
 }
 
 /**
@@ -417,19 +514,9 @@ static Poly ParserMonos(const char *line, size_t line_length, size_t line_number
     }
 
     for (size_t i = 1; i <= count; i++) {
-        Poly p = ParserMono(line + arr[i - 1] + 1, arr[i] - arr[i - 1] - 1, line_number, valid, false);
-
-        if (*valid) {
-            if (PolyIsCoeff(&p)) {
-                monos[i - 1] = (Mono) {.p = p, .exp = 0};
-            }
-            else {
-                monos[i - 1] = p.arr[0];
+        monos[i - 1] = ParserMono(line + arr[i - 1] + 1, arr[i] - arr[i - 1] - 1, line_number, valid, false);
 
-                free(p.arr);
-            }
-        }
-        else {
+        if (!(*valid)) {
             for (size_t j = 0; j < i - 1; j++) {
                 MonoDestroy(&monos[j]);
             }
@@ -495,7 +582,9 @@ static Poly ParserPolyAux(const char *line, size_t line_length, size_t line_numb
             }
         }
 
-        return ParserMono(line, line_length, line_number, valid, write);
+        Mono m = ParserMono(line, line_length, line_number, valid, write);
+
+        return PolyAddMonos(1, &m);
 
     }
     else {
@@ -554,9 +643,33 @@ int ParserCommand(const char *line, size_t line_length, size_t line_number) {
     else if (!strcmp(line, "POP\n") || !strcmp(line, "POP")) {
         return POP;
     }
+    else if (!strcmp(line, "COMPILE\n") || !strcmp(line, "COMPILE")) {
+        return COMPILE;
+    }
+    else if (!strcmp(line, "INTERN\n") || !strcmp(line, "INTERN")) {
+        return INTERN;
+    }
+    else if (!strcmp(line, "CACHE_ON\n") || !strcmp(line, "CACHE_ON")) {
+        return CACHE_ON;
+    }
+    else if (!strcmp(line, "CACHE_OFF\n") || !strcmp(line, "CACHE_OFF")) {
+        return CACHE_OFF;
+    }
+    else if (!strncmp(line, "RUN", 3)) {
+        return ParserCommandValues(line, line_length, line_number, "RUN", RUN);
+    }
+    else if (!strncmp(line, "EVAL", 4)) {
+        return ParserCommandValues(line, line_length, line_number, "EVAL", EVAL);
+    }
+    else if (!strncmp(line, "AT_MANY", 7)) {
+        return ParserCommandValues(line, line_length, line_number, "AT_MANY", AT_MANY);
+    }
     else if (!memcmp(line, "AT", 2)) {
         return ParserCommandAt(line, line_length, line_number);
     }
+    else if (!strncmp(line, "POW", 3)) {
+        return ParserCommandPow(line, line_length, line_number);
+    }
     else if (!memcmp(line, "DEG_BY", 6)) {
         return ParserCommandDegBy(line, line_length, line_number);
     }
@@ -570,6 +683,23 @@ int ParserCommand(const char *line, size_t line_length, size_t line_number) {
     }
 }
 
+poly_coeff_t* ParserValues(const char *line, size_t *count) {
+    *count = 0;
+    for (const char *c = line; *c != '\0'; c++) {
+        *count += *c == ' ';
+    }
+
+    poly_coeff_t *values = malloc(*count * sizeof(poly_coeff_t));
+    CHECK_PTR(values);
+
+    char *end = (char*)line;
+    for (size_t i = 0; i < *count; i++) {
+        values[i] = strtoll(end, &end, 10);
+    }
+
+    return values;
+}
+
 Poly ParserPoly(const char *line, size_t line_length, size_t line_number, bool *valid) {
     if (line[line_length - 1] == '\n') {
         return ParserPoly(line, line_length - 1, line_number, valid);
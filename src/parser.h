@@ -28,7 +28,15 @@ enum commands {
     AT = 12,
     PRINT = 13,
     POP = 14,
-    COMPOSE = 15
+    COMPOSE = 15,
+    AT_MANY = 16,
+    EVAL = 17,
+    COMPILE = 18,
+    RUN = 19,
+    POW = 20,
+    INTERN = 21,
+    CACHE_ON = 22,
+    CACHE_OFF = 23
 };
 
 /**
@@ -43,6 +51,16 @@ enum commands {
  */ 
 int ParserCommand(const char *line, size_t line_length, size_t line_number);
 
+/**
+ * Odczytuje listę wartości oddzielonych pojedynczymi spacjami.
+ * Zakłada, że wiersz przeszedł weryfikację w ParserCommand
+ * i że @p line wskazuje na spację przed pierwszą wartością.
+ * @param[in] line : fragment wiersza z wartościami
+ * @param[out] count : wskaźnik na zmienną, w której zostanie zapisana liczba wartości
+ * @return tablica wartości
+ */ 
+poly_coeff_t* ParserValues(const char *line, size_t *count);
+
 /**
  * Rozpoznaje, czy wiersz zawiera poprawny wielomian.
  * Jeżeli nie jest, ustawia wartość @p *valid na false.
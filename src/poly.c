@@ -5,148 +5,377 @@
   @date 2021
 */
 
+#include "arena.h"
 #include "check_ptr.h"
+#include "dense.h"
+#include "mono_sort.h"
 #include "poly.h"
+#include "poly_cache.h"
+#include "poly_math.h"
+#include "poly_pool.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * Zwraca maksimum z dwóch liczb.
- * @param[in] x : liczba
- * @param[in] y : liczba
- * @return @f$ \max(x, y) @f$
+ * Arena na tablice pomocnicze operacji. Każda funkcja zapamiętuje znacznik
+ * przed przydziałem swoich tablic i po ich ostatnim użyciu zwalnia arenę do
+ * tego znacznika, więc tablice wywołań zagnieżdżonych są zwalniane wcześniej
+ * niż tablice wywołań zewnętrznych. Tablice jednomianów nie trafiają do areny.
+ * Każdy wątek ma własną arenę (zob. model wątków opisany w poly.h).
  */
-#define MAX(x, y) (((x) >= (y)) ? (x) : (y)) 
+static _Thread_local Arena scratch_arena = {.block = NULL};
+
+void PolyScratchFree(void) {
+    ArenaFree(&scratch_arena);
+}
 
 /**
- * Podnosi liczbę do potęgi.
- * @param[in] base : podstawa
- * @param[in] exponent : wykładnik
- * @return @f$ \text{base} ^ {\text{exponent}} @f$
+ * Metadane wielomianu niebędącego współczynnikiem. Są przechowywane
+ * w nagłówku tuż przed tablicą jednomianów, więc nie zmieniają układu
+ * struktury Poly. Tablice jednomianów wielomianów są przydzielane wyłącznie
+ * funkcjami MonosAlloc, MonosReserve i MonosAdopt, a zwalniane funkcją
+ * MonosFree; wszystkie one korzystają z puli (zob. poly_pool.h) przez funkcję
+ * MonosResize. Metadane są wyliczane przy tworzeniu wielomianu (w funkcji
+ * Simplify), a operacje modyfikujące tablicę jednomianów w miejscu je
+ * unieważniają; wtedy są wyliczane ponownie przy pierwszym użyciu.
+ * Największy wykładnik nie jest zapamiętywany, bo jest wykładnikiem
+ * ostatniego jednomianu.
+ *
+ * Tablica jednomianów może być współdzielona przez wiele wielomianów
+ * (PolyClone tylko zwiększa licznik odwołań). Przed modyfikacją tablicy
+ * w miejscu należy wywołać PolyUnshare. Tablica może też należeć do
+ * tablicy wielomianów internowanych (zob. PolyInternOwn).
  */
-static poly_coeff_t Exp(const poly_coeff_t base, const poly_exp_t exponent) {
-    if (exponent == 0) {
-        return 1;
-    }
-    else if (exponent % 2 == 0) {
-        return Exp(base * base, exponent / 2);
+typedef struct PolyMeta {
+    uint64_t hash; ///< skrót struktury wielomianu
+    size_t terms; ///< liczba niezerowych współczynników liczbowych
+    size_t refs; ///< liczba wielomianów współdzielących tablicę
+    size_t bytes; ///< łączny rozmiar bloków tablicy i tablic współczynników w bajtach
+    poly_exp_t deg; ///< stopień wielomianu
+    unsigned depth; ///< liczba zmiennych, od których wielomian może zależeć; zero oznacza nieaktualne metadane
+    bool interned; ///< czy wielomian jest w tablicy wielomianów internowanych?
+    unsigned char pool_class; ///< klasa bloku w puli pamięci
+    unsigned capacity; ///< liczba jednomianów, na którą przydzielono blok
+} PolyMeta;
+
+/**
+ * Zwraca nagłówek tablicy jednomianów.
+ * @param[in] monos : tablica jednomianów
+ * @return metadane zapisane przed tablicą
+ */
+static inline PolyMeta *MonosMeta(const Mono *monos) {
+    return (PolyMeta *)monos - 1;
+}
+
+/**
+ * Przydziela, zmienia rozmiar albo zwalnia tablicę jednomianów wraz
+ * z nagłówkiem. Jedyne miejsce, w którym tablice jednomianów trafiają do puli
+ * pamięci albo z niej wracają. Metadane nowej tablicy są nieaktualne.
+ * @param[in] monos : tablica jednomianów lub NULL
+ * @param[in] count : liczba jednomianów lub 0, żeby zwolnić tablicę
+ * @return tablica po zmianie rozmiaru albo NULL po zwolnieniu
+ */
+static Mono *MonosResize(Mono *monos, size_t count) {
+    unsigned char pool_class = monos == NULL ? 0 : MonosMeta(monos)->pool_class;
+    PolyMeta *meta = PolyPoolResize(monos == NULL ? NULL : MonosMeta(monos), &pool_class,
+                                    count == 0 ? 0 : sizeof(PolyMeta) + count * sizeof(Mono));
+
+    if (meta == NULL) {
+        return NULL;
     }
-    else {
-        return base * Exp(base, exponent - 1);
+    else if (monos == NULL) {
+        meta->refs = 1;
+        meta->depth = 0;
+        meta->interned = false;
     }
+
+    meta->pool_class = pool_class;
+    meta->capacity = count > UINT_MAX ? UINT_MAX : (unsigned)count;
+
+    return (Mono *)(meta + 1);
 }
 
 /**
- * Porównuje jednomiany względem wykładników.
- * @param[in] ptr_m1 : jednomian @f$m_1@f$
- * @param[in] ptr_m2 : jednomian @f$m_2@f$
- * @return 1, jeżeli @f$m_1@f$ ma większy stopień
- * @return 0, jeżeli stopnie są równe
- * @return -1, jeżeli @f$m_1@f$ ma mniejszy stopień
+ * Zwraca rozmiar bloku tablicy jednomianów wraz z nagłówkiem, z uwzględnieniem
+ * zaokrąglenia do klasy puli.
+ * @param[in] monos : tablica jednomianów
+ * @return rozmiar bloku w bajtach
  */
-static int MonoCompare(const void *ptr_m1, const void *ptr_m2) {
-    Mono *m1 = (Mono *)ptr_m1;
-    Mono *m2 = (Mono *)ptr_m2;
+static size_t MonosBlockBytes(const Mono *monos) {
+    const PolyMeta *meta = MonosMeta(monos);
 
-    return (MonoGetExp(m1) > MonoGetExp(m2)) - (MonoGetExp(m1) < MonoGetExp(m2));
+    return PolyPoolBlockSize(meta->pool_class, sizeof(PolyMeta) + meta->capacity * sizeof(Mono));
 }
 
-void PolyDestroy(Poly *p) {
-    if (!PolyIsCoeff(p)) {
-        for (size_t i = 0; i < p->size; i++) {
-            MonoDestroy(&p->arr[i]);
-        }
+/**
+ * Przydziela tablicę jednomianów z nagłówkiem na metadane.
+ * @param[in] count : liczba jednomianów
+ * @return tablica jednomianów z nieaktualnymi metadanymi
+ */
+static Mono *MonosAlloc(size_t count) {
+    return MonosResize(NULL, count == 0 ? 1 : count);
+}
 
-        free(p->arr);
+/**
+ * Zmienia rozmiar tablicy jednomianów tak, żeby mieściła co najmniej @p size
+ * jednomianów. Pojemność zaokrąglamy w górę do potęgi dwójki: zmiana rozmiaru
+ * na taki, który już się mieści w bloku, nie kopiuje pamięci, więc wielokrotne
+ * powiększanie tej samej tablicy ma zamortyzowany koszt stały.
+ * @param[in] monos : tablica jednomianów lub NULL
+ * @param[in] size : liczba jednomianów
+ * @return tablica po zmianie rozmiaru
+ */
+static Mono *MonosReserve(Mono *monos, size_t size) {
+    size_t capacity = 1;
+    while (capacity < size) {
+        capacity *= 2;
     }
+
+    return MonosResize(monos, capacity);
 }
 
-Poly PolyClone(const Poly *p) {
-    if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->coeff);
+/**
+ * Zamienia tablicę jednomianów przydzieloną przez użytkownika funkcją malloc
+ * na tablicę z nagłówkiem. Przejmuje na własność tablicę @p monos.
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów lub NULL
+ * @return tablica z tymi samymi jednomianami lub NULL
+ */
+static Mono *MonosAdopt(size_t count, Mono *monos) {
+    if (monos == NULL) {
+        return NULL;
     }
-    else {
-        Mono *arr = malloc(p->size * sizeof(Mono));
-        CHECK_PTR(arr);
-        
-        for (size_t i = 0; i < p->size; i++) {
-            arr[i] = MonoClone(&p->arr[i]);
-        }
 
-        return (Poly) {.size = p->size, .arr = arr};
-    }
+    Mono *arr = MonosAlloc(count);
+
+    memcpy(arr, monos, count * sizeof(Mono));
+    free(monos);
+
+    return arr;
 }
 
 /**
- * Sumuje listę jednomianów i tworzy z nich wielomian.
- * Zakłada, że lista jest posortowana niemalejąco ze względu na stopień.
- * Przejmuje na własność zawartość tablicy @p monos.
- * @param[in] count : liczba jednomianów
- * @param[in] monos : tablica jednomianów
- * @return wielomian będący sumą jednomianów
+ * Zwalnia tablicę jednomianów wraz z nagłówkiem (bez jej zawartości).
+ * @param[in] monos : tablica jednomianów lub NULL
  */
-static Poly PolyAddSortedMonos(size_t count, Mono monos[]) {
-    if (count > 0) {
-        for (size_t i = 0; i < count - 1; i++) {
-            assert(MonoGetExp(&monos[i]) <= MonoGetExp(&monos[i + 1]));
+static void MonosFree(Mono *monos) {
+    MonosResize(monos, 0);
+}
+
+/**
+ * Miesza bity liczby (funkcja kończąca z MurmurHash3).
+ * @param[in] h : liczba
+ * @return wymieszana liczba
+ */
+static inline uint64_t HashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static const PolyMeta *PolyGetMeta(const Poly *p);
+
+uint64_t PolyHash(const Poly *p) {
+    return PolyIsCoeff(p) ? HashMix((uint64_t)p->coeff) : PolyGetMeta(p)->hash;
+}
+
+/**
+ * Wylicza metadane wielomianu z metadanych jego współczynników
+ * (które w razie potrzeby są wyliczane rekurencyjnie).
+ * @param[in] p : wielomian niebędący współczynnikiem
+ */
+static void PolyMetaUpdate(const Poly *p) {
+    PolyMeta *meta = MonosMeta(p->arr);
+    uint64_t hash = p->size;
+    size_t terms = 0;
+    size_t bytes = MonosBlockBytes(p->arr);
+    poly_exp_t deg = 0;
+    unsigned depth = 0;
+
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *c = &p->arr[i].p;
+        poly_exp_t exp = MonoGetExp(&p->arr[i]);
+
+        hash = HashMix((hash ^ PolyHash(c)) + (uint64_t)exp * 0x9e3779b97f4a7c15ULL);
+
+        if (PolyIsCoeff(c)) {
+            terms++;
+            deg = MAX(deg, exp);
+        }
+        else {
+            const PolyMeta *m = PolyGetMeta(c);
+
+            terms += m->terms;
+            bytes += m->bytes;
+            deg = MAX(deg, exp + m->deg);
+            depth = MAX(depth, m->depth);
         }
     }
 
-    if (count == 0 || monos == NULL) {
-        return PolyZero();
+    meta->hash = hash;
+    meta->terms = terms;
+    meta->bytes = bytes;
+    meta->deg = deg;
+    meta->depth = depth + 1;
+}
+
+/**
+ * Zwraca metadane wielomianu, wyliczając je, jeżeli są nieaktualne.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return metadane
+ */
+static const PolyMeta *PolyGetMeta(const Poly *p) {
+    if (MonosMeta(p->arr)->depth == 0) {
+        PolyMetaUpdate(p);
     }
 
-    size_t size = 1;
-    for (size_t i = 0; i < count - 1; i++) {
-        if (MonoGetExp(&monos[i]) < MonoGetExp(&monos[i + 1])) {
-            size++;
-        }
+    return MonosMeta(p->arr);
+}
+
+/**
+ * Unieważnia metadane wielomianu po zmianie jego tablicy jednomianów w miejscu.
+ * @param[in] p : wielomian
+ */
+static inline void PolyMetaInvalidate(const Poly *p) {
+    if (!PolyIsCoeff(p)) {
+        MonosMeta(p->arr)->depth = 0;
     }
+}
 
-    Mono *arr = malloc(size * sizeof(Mono));
-    CHECK_PTR(arr);
+/**
+ * Tablica wielomianów internowanych: zbiór z adresowaniem otwartym
+ * i liniowym próbkowaniem, indeksowany skrótami wielomianów. Tablica nie
+ * jest właścicielem wielomianów; wielomian jest z niej usuwany, gdy jest
+ * niszczony lub modyfikowany w miejscu.
+ */
+typedef struct InternTable {
+    size_t size; ///< liczba wielomianów
+    size_t capacity; ///< liczba miejsc (zero albo potęga dwójki)
+    Poly *slots; ///< miejsca; puste mają `arr == NULL`
+} InternTable;
+
+/**
+ * Początkowa liczba miejsc w tablicy wielomianów internowanych.
+ */
+#define INTERN_INITIAL_CAPACITY 64
 
-    size_t j = 0, k = 0;
-    for (size_t i = 0; i < size - k; i++) {
-        arr[i] = MonoClone(&monos[j]);
+/**
+ * Tablica wielomianów internowanych bieżącego wątku.
+ */
+static _Thread_local InternTable intern_table = {.size = 0, .capacity = 0, .slots = NULL};
 
-        while (j < count - 1 && MonoGetExp(&monos[j]) == MonoGetExp(&monos[j + 1])) {
-            j++; 
+/**
+ * Zwraca miejsce, od którego zaczynamy szukać wielomianu o danym skrócie.
+ * @param[in] hash : skrót
+ * @return indeks miejsca
+ */
+static inline size_t InternSlot(uint64_t hash) {
+    return hash & (intern_table.capacity - 1);
+}
 
-            Mono m = (Mono) {.p = PolyAdd(&arr[i].p, &monos[j].p), .exp = MonoGetExp(&arr[i])};
+/**
+ * Usuwa wielomian z tablicy wielomianów internowanych. Elementy za usuniętym
+ * są przesuwane wstecz, więc tablica nie potrzebuje znaczników usunięcia.
+ * @param[in] p : wielomian internowany
+ */
+static void InternRemove(const Poly *p) {
+    size_t mask = intern_table.capacity - 1;
+    size_t i = InternSlot(MonosMeta(p->arr)->hash);
+    while (intern_table.slots[i].arr != p->arr) {
+        i = (i + 1) & mask;
+    }
 
-            MonoDestroy(&arr[i]); 
+    for (size_t j = (i + 1) & mask; intern_table.slots[j].arr != NULL; j = (j + 1) & mask) {
+        // Element z miejsca j może zająć miejsce i, jeżeli i leży na jego ścieżce próbkowania.
+        size_t home = InternSlot(MonosMeta(intern_table.slots[j].arr)->hash);
 
-            arr[i] = m;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            intern_table.slots[i] = intern_table.slots[j];
+            i = j;
         }
+    }
 
-        if (PolyIsZero(&arr[i].p)) {
-            i--;
-            k++;
+    intern_table.slots[i].arr = NULL;
+    intern_table.size--;
+    MonosMeta(p->arr)->interned = false;
+
+    if (intern_table.size == 0) {
+        free(intern_table.slots);
+        intern_table = (InternTable) {.size = 0, .capacity = 0, .slots = NULL};
+    }
+}
+
+void PolyDestroy(Poly *p) {
+    if (!PolyIsCoeff(p) && --MonosMeta(p->arr)->refs == 0) {
+        if (MonosMeta(p->arr)->interned) {
+            InternRemove(p);
+        }
+
+        for (size_t i = 0; i < p->size; i++) {
+            MonoDestroy(&p->arr[i]);
         }
 
-        j++;
+        MonosFree(p->arr);
     }
+}
 
-    for (size_t i = 0; i < count; i++) {
-        MonoDestroy(&monos[i]);
+Poly PolyClone(const Poly *p) {
+    if (!PolyIsCoeff(p)) {
+        MonosMeta(p->arr)->refs++;
     }
 
-    if (size - k == 0) {
-        free(arr);
+    return *p;
+}
 
-        return PolyZero();
-    }
-    else if (size - k == 1 && MonoGetExp(&arr[0]) == 0 && PolyIsCoeff(&arr[0].p)) {
-        Poly r = PolyFromCoeff(arr[0].p.coeff);
+/**
+ * Sprawdza, czy tablica jednomianów wielomianu jest współdzielona.
+ * @param[in] p : wielomian
+ * @return czy @p p nie jest współczynnikiem i jego tablica ma innych właścicieli?
+ */
+static inline bool PolyIsShared(const Poly *p) {
+    return !PolyIsCoeff(p) && MonosMeta(p->arr)->refs > 1;
+}
 
-        free(arr);
+/**
+ * Zapewnia, że tablicę jednomianów wielomianu można modyfikować w miejscu:
+ * tablicę współdzieloną zastępuje kopią, a niewspółdzieloną usuwa z tablicy
+ * wielomianów internowanych. Kopiowana jest tylko tablica, a współczynniki
+ * pozostają współdzielone.
+ * @param[in, out] p : wielomian
+ */
+static void PolyUnshare(Poly *p) {
+    if (!PolyIsShared(p)) {
+        if (!PolyIsCoeff(p) && MonosMeta(p->arr)->interned) {
+            InternRemove(p);
+        }
 
-        return r;
+        return;
     }
-    else {
-        return (Poly) {.size = size - k, .arr = arr};
+
+    PolyMeta *meta = MonosMeta(p->arr);
+    Mono *arr = MonosAlloc(p->size);
+    PolyMeta copy = *MonosMeta(arr);
+
+    *MonosMeta(arr) = *meta;
+    MonosMeta(arr)->refs = 1;
+    MonosMeta(arr)->interned = false;
+    MonosMeta(arr)->pool_class = copy.pool_class;
+    MonosMeta(arr)->capacity = copy.capacity;
+    MonosMeta(arr)->bytes = meta->bytes - MonosBlockBytes(p->arr) + MonosBlockBytes(arr);
+    meta->refs--;
+
+    for (size_t i = 0; i < p->size; i++) {
+        arr[i] = MonoClone(&p->arr[i]);
     }
+
+    p->arr = arr;
 }
 
 /**
@@ -158,209 +387,1508 @@ static Poly PolyAddSortedMonos(size_t count, Mono monos[]) {
  * @return urposzczony wielomian składający się z jednomianów z @p monos
  */ 
 static Poly Simplify(size_t size, Mono monos[]) {
-    if (size == 1) {
-        if ((monos[0].exp == 0 && PolyIsCoeff(&(monos[0].p))) || 
-            PolyIsZero(&(monos[0].p))) {
-
-            Poly p = monos[0].p;
-
-            free(monos);
-            
-            return p;
-        }
-        else {
-            return (Poly) {.arr = monos, .size = 1};
-        }
-    }
-
     size_t new_size = 0;
 
     for (size_t i = 0; i < size; i++) {
         if (!PolyIsZero(&(monos[i].p))) {
+            monos[new_size] = monos[i];
+
             new_size++;
         }
     }
 
-    if (new_size == size) {
-        return (Poly) {.arr = monos, .size = size};
+    if (new_size == 0) {
+        MonosFree(monos);
+
+        return PolyZero();
     }
-    else if (new_size == 1) {
-        size_t i = 0;
-        while (PolyIsZero(&(monos[i].p))) {
-            i++;
-        }
+    else if (new_size == 1 && monos[0].exp == 0 && PolyIsCoeff(&(monos[0].p))) {
+        Poly p = monos[0].p;
+
+        MonosFree(monos);
 
-        Mono *new_monos = malloc(sizeof(Mono));
-        CHECK_PTR(new_monos);
+        return p;
+    }
+    else if (new_size < size) {
+        monos = MonosReserve(monos, new_size);
+    }
+
+    Poly p = (Poly) {.arr = monos, .size = new_size};
+
+    PolyMetaUpdate(&p);
 
-        new_monos[0] = monos[i];
+    return p;
+}
+
+/**
+ * Liczba kolejnych jednomianów z tej samej tablicy, po której scalanie
+ * przechodzi od porównywania jednomian po jednomianie do wyszukiwania
+ * wykładniczego (jak w algorytmie Timsort). Krótkie serie są częste,
+ * a dla nich galop jest wolniejszy od zwykłego scalania.
+ */
+#define GALLOP_MIN 8
 
-        free(monos);
+/**
+ * Wyszukuje wykładniczo (z galopem) koniec serii jednomianów o wykładnikach
+ * mniejszych od @p exp, zaczynającej się na pozycji @p begin. Sprawdzamy
+ * pozycje @f$begin + 1, begin + 2, begin + 4, \ldots@f$, a potem
+ * wyszukujemy binarnie w ostatnim przedziale, więc koszt jest logarytmiczny
+ * względem długości serii, a nie długości tablicy.
+ * Zakładamy, że `arr[begin].exp < exp`.
+ * @param[in] arr : tablica jednomianów posortowana ściśle rosnąco
+ * @param[in] begin : początek serii
+ * @param[in] end : koniec przeszukiwanego zakresu
+ * @param[in] exp : wykładnik
+ * @return pierwsza pozycja w @f$[begin, end)@f$ z wykładnikiem nie mniejszym
+ * niż @p exp lub @p end
+ */
+static inline size_t MonosGallop(const Mono arr[], size_t begin, size_t end, poly_exp_t exp) {
+    size_t lo = begin;
+    size_t step = 1;
 
-        return Simplify(1, new_monos);
+    while (step < end - lo && arr[lo + step].exp < exp) {
+        lo += step;
+        step *= 2;
     }
-    else if (new_size == 0) {
-        free(monos);
 
-        return PolyZero();
+    size_t hi = step < end - lo ? lo + step : end;
+
+    // arr[lo].exp < exp, a pozycja hi ma wykładnik nie mniejszy lub jest końcem.
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (arr[mid].exp < exp) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
     }
-    
-    Mono* new_monos = malloc(new_size * sizeof(Mono));
-    CHECK_PTR(new_monos);
 
-    size_t j = 0;
-    for (size_t i = 0; i < size; i++) {
-        if (!PolyIsZero(&(monos[i].p))) {
-            new_monos[j] = monos[i];
-            
-            j++;
+    return hi;
+}
+
+/**
+ * Wyszukuje wykładniczo początek serii jednomianów o wykładnikach większych
+ * od @p exp, kończącej się przed pozycją @p end. Działa jak MonosGallop,
+ * ale od końca tablicy. Zakładamy, że `arr[end - 1].exp > exp`.
+ * @param[in] arr : tablica jednomianów posortowana ściśle rosnąco
+ * @param[in] end : koniec serii
+ * @param[in] exp : wykładnik
+ * @return najmniejsza pozycja, od której do @p end wszystkie wykładniki są
+ * większe od @p exp
+ */
+static inline size_t MonosGallopBack(const Mono arr[], size_t end, poly_exp_t exp) {
+    size_t hi = end - 1;
+    size_t step = 1;
+
+    while (step <= hi && arr[hi - step].exp > exp) {
+        hi -= step;
+        step *= 2;
+    }
+
+    // Pozycja lo ma wykładnik nie większy od exp albo jest przed początkiem tablicy.
+    size_t lo = step <= hi ? hi - step + 1 : 0;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (arr[mid].exp > exp) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
         }
     }
 
-    free(monos);
+    return hi;
+}
+
+/**
+ * Kopiuje wielomian, w razie potrzeby negując przy tym jego współczynniki.
+ * @param[in] p : wielomian
+ * @param[in] negate : czy negować współczynniki
+ * @return @f$p@f$ lub @f$-p@f$
+ */
+static Poly PolyCloneSigned(const Poly *p, bool negate) {
+    if (!negate) {
+        return PolyClone(p);
+    }
+    else if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(-p->coeff);
+    }
+
+    Mono *arr = MonosAlloc(p->size);
 
-    return (Poly) {.arr = new_monos, .size = new_size};
+    for (size_t i = 0; i < p->size; i++) {
+        arr[i] = (Mono) {.p = PolyCloneSigned(&p->arr[i].p, true), .exp = p->arr[i].exp};
+    }
+
+    Poly r = (Poly) {.size = p->size, .arr = arr};
+
+    PolyMetaUpdate(&r);
+
+    return r;
 }
 
-Poly PolyAdd(const Poly *p, const Poly *q) {
+/**
+ * Dodaje lub odejmuje dwa wielomiany w jednym przejściu scalającym.
+ * Współczynniki @p q są negowane w trakcie kopiowania, więc odejmowanie
+ * nie tworzy pomocniczego wielomianu @f$-q@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] negate : czy odejmować
+ * @return @f$p + q@f$ lub @f$p - q@f$
+ */
+static Poly PolyMerge(const Poly *p, const Poly *q, bool negate) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return PolyFromCoeff(p->coeff + q->coeff);
+        return PolyFromCoeff(negate ? p->coeff - q->coeff : p->coeff + q->coeff);
+    }
+    else if (PolyIsZero(p)) {
+        return PolyCloneSigned(q, negate);
+    }
+    else if (PolyIsZero(q)) {
+        return PolyClone(p);
     }
-    else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
-        Mono *arr = malloc((p->size + q->size) * sizeof(Mono));
-        CHECK_PTR(arr);
 
-        size_t i_p = 0;
-        size_t i_q = 0;
-        size_t i = 1;
+    // Współczynnik traktujemy jak wielomian z jednym jednomianem stopnia 0.
+    Mono p_mono = (Mono) {.p = *p, .exp = 0};
+    Mono q_mono = (Mono) {.p = *q, .exp = 0};
+    size_t p_size = PolyIsCoeff(p) ? 1 : p->size;
+    size_t q_size = PolyIsCoeff(q) ? 1 : q->size;
+    const Mono *p_arr = PolyIsCoeff(p) ? &p_mono : p->arr;
+    const Mono *q_arr = PolyIsCoeff(q) ? &q_mono : q->arr;
+
+    Mono *arr = MonosAlloc(p_size + q_size);
+
+    size_t i_p = 0;
+    size_t i_q = 0;
+    size_t i = 0;
+
+    // Długie serie jednomianów jednego składnika mniejsze od bieżącego
+    // jednomianu drugiego wyszukujemy galopem (zob. MonosGallop).
+    size_t p_streak = 0;
+    size_t q_streak = 0;
+
+    while (i_p < p_size || i_q < q_size) {
+        if (i_q == q_size || (i_p < p_size && p_arr[i_p].exp < q_arr[i_q].exp)) {
+            size_t end = i_q == q_size ? p_size
+                         : ++p_streak < GALLOP_MIN ? i_p + 1 : MonosGallop(p_arr, i_p, p_size, q_arr[i_q].exp);
+
+            q_streak = 0;
+            while (i_p < end) {
+                arr[i++] = MonoClone(&p_arr[i_p++]);
+            }
+        }
+        else if (i_p == p_size || q_arr[i_q].exp < p_arr[i_p].exp) {
+            size_t end = i_p == p_size ? q_size
+                         : ++q_streak < GALLOP_MIN ? i_q + 1 : MonosGallop(q_arr, i_q, q_size, p_arr[i_p].exp);
 
-        if (p->arr[0].exp <= q->arr[0].exp) {
-            arr[0] = MonoClone(&(p->arr[0]));
-            
-            i_p++;
+            p_streak = 0;
+            for (; i_q < end; i_q++) {
+                arr[i++] = (Mono) {.p = PolyCloneSigned(&q_arr[i_q].p, negate), .exp = q_arr[i_q].exp};
+            }
         }
         else {
-            arr[0] = MonoClone(&(q->arr[0]));
+            Poly r = PolyMerge(&p_arr[i_p].p, &q_arr[i_q].p, negate);
+
+            p_streak = 0;
+            q_streak = 0;
+
+            if (!PolyIsZero(&r)) {
+                arr[i++] = (Mono) {.p = r, .exp = p_arr[i_p].exp};
+            }
 
+            i_p++;
             i_q++;
         }
+    }
 
-        while (i_p + i_q < p->size + q->size) {
-            if ((i_p == p->size && i_q < q->size) || 
-                (!(i_p < p->size && i_q == q->size) && p->arr[i_p].exp > q->arr[i_q].exp)) {
-                if (arr[i - 1].exp == q->arr[i_q].exp) {
-                    Poly r = PolyAdd(&(arr[i - 1].p), &(q->arr[i_q].p));
+    return Simplify(i, arr);
+}
 
-                    PolyDestroy(&(arr[i - 1].p));
+Poly PolyAdd(const Poly *p, const Poly *q) {
+    return PolyMerge(p, q, false);
+}
 
-                    arr[i - 1].p = r;
-                }
-                else {
-                    arr[i] = MonoClone(&(q->arr[i_q]));
+/**
+ * Scala posortowaną ściśle rosnąco tablicę jednomianów z wielomianem
+ * niebędącym współczynnikiem, w miejscu. Tablica jednomianów wielomianu jest
+ * powiększana funkcją MonosReserve, a scalanie odbywa się od końca, więc
+ * jednomiany wielomianu, których jeszcze nie przetworzyliśmy, nie są
+ * nadpisywane. Koszt jest proporcjonalny do liczby jednomianów wielomianu
+ * o wykładnikach nie mniejszych od najmniejszego wykładnika z @p monos.
+ * @param[in, out] acc : wielomian
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @param[in] own : czy przejąć jednomiany na własność (w przeciwnym
+ * przypadku są kopiowane)
+ */
+static void PolyMergeMonos(Poly *acc, size_t count, Mono monos[], bool own) {
+    assert(!PolyIsCoeff(acc));
 
-                    i++;
-                }
+    PolyUnshare(acc);
 
-                i_q++;
-            }
-            else {
-                if (arr[i - 1].exp == p->arr[i_p].exp) {
-                    Poly r = PolyAdd(&(arr[i - 1].p), &(p->arr[i_p].p));
+    size_t size = acc->size + count;
+    Mono *arr = MonosReserve(acc->arr, size);
 
-                    PolyDestroy(&(arr[i - 1].p));
+    size_t i_p = acc->size;
+    size_t i_q = count;
+    size_t i = size;
 
-                    arr[i - 1].p = r;
-                }
-                else {
-                    arr[i] = MonoClone(&(p->arr[i_p]));
+    // Długie serie jednomianów większe od bieżącego jednomianu drugiej
+    // tablicy wyszukujemy galopem (zob. MonosGallopBack) i przenosimy w całości.
+    size_t p_streak = 0;
+    size_t q_streak = 0;
 
-                    i++;
-                }
+    while (i_q > 0) {
+        if (i_p > 0 && arr[i_p - 1].exp > monos[i_q - 1].exp) {
+            q_streak = 0;
 
-                i_p++;
+            if (++p_streak < GALLOP_MIN) {
+                arr[--i] = arr[--i_p];
             }
-        }
+            else {
+                size_t begin = MonosGallopBack(arr, i_p, monos[i_q - 1].exp);
 
-        return Simplify(i, arr);
-    }
-    else {
-        if (PolyIsCoeff(p)) {
-            return PolyAdd(q, p);
+                i -= i_p - begin;
+                memmove(&arr[i], &arr[begin], (i_p - begin) * sizeof(Mono));
+                i_p = begin;
+            }
         }
+        else if (i_p > 0 && arr[i_p - 1].exp == monos[i_q - 1].exp) {
+            i_p--;
+            i_q--;
+            p_streak = 0;
+            q_streak = 0;
+
+            if (own) {
+                arr[i_p].p = PolyAddOwn(arr[i_p].p, monos[i_q].p);
+            }
+            else {
+                PolyAddTo(&arr[i_p].p, &monos[i_q].p);
+            }
 
-        Mono arr[] = {(Mono) {.p = PolyClone(q), .exp = 0}};
-
-        Poly r = (Poly) {.arr = arr, .size = 1};
+            arr[--i] = arr[i_p];
+        }
+        else {
+            size_t begin = i_p == 0 ? 0
+                           : ++q_streak < GALLOP_MIN ? i_q - 1 : MonosGallopBack(monos, i_q, arr[i_p - 1].exp);
 
-        return PolyAdd(p, &r);
+            p_streak = 0;
+            while (i_q > begin) {
+                i_q--;
+                arr[--i] = own ? monos[i_q] : MonoClone(&monos[i_q]);
+            }
+        }
     }
-}
 
-/**
- * Sprawdza, czy tablica jednomianów jest posortowana (rosnąco, względem mianowników).
- * @param[in] count : liczba elementów tablicy
- * @param[in] monos : tablica
- * @return czy tablica jest posortowana?
- */ 
-static bool isSorted(size_t count, const Mono monos[]) {
-    bool sorted = true;
+    // Zera mogły powstać tylko w scalonej części, więc tylko ją przeglądamy.
+    size_t new_size = i_p;
+    for (; i < size; i++) {
+        if (!PolyIsZero(&arr[i].p)) {
+            arr[new_size] = arr[i];
 
-    if (count > 0) {
-        for (size_t i = 0; i < count - 1; i++) {
-            sorted &= (MonoGetExp(&monos[i]) <= MonoGetExp(&monos[i + 1]));
+            new_size++;
         }
     }
 
-    return sorted;
+    if (new_size <= 1) {
+        *acc = Simplify(new_size, arr);
+    }
+    else {
+        *acc = (Poly) {.arr = arr, .size = new_size};
+
+        PolyMetaInvalidate(acc);
+    }
 }
 
-Poly PolyAddMonos(size_t count, const Mono monos[]) {
-    Mono *arr = malloc(count * sizeof(Mono));
-    CHECK_PTR(arr);
-    
-    for (size_t i = 0; i < count; i++) {
-        arr[i] = monos[i];
+Poly PolyAddOwn(Poly p, Poly q) {
+    if (PolyIsCoeff(&p) && PolyIsCoeff(&q)) {
+        return PolyFromCoeff(p.coeff + q.coeff);
+    }
+    else if (PolyIsCoeff(&p) || (!PolyIsCoeff(&q) && p.size < q.size)) {
+        return PolyAddOwn(q, p);
+    }
+    else if (PolyIsCoeff(&q)) {
+        if (!PolyIsZero(&q)) {
+            Mono m = (Mono) {.p = q, .exp = 0};
+
+            PolyMergeMonos(&p, 1, &m, true);
+        }
     }
+    else if (PolyIsShared(&q)) {
+        PolyMergeMonos(&p, q.size, q.arr, false);
 
-    if (!isSorted(count, arr)) {
-        qsort(arr, count, sizeof(Mono), MonoCompare);
+        PolyDestroy(&q);
     }
+    else {
+        PolyUnshare(&q);
+        PolyMergeMonos(&p, q.size, q.arr, true);
 
-    Poly r = PolyAddSortedMonos(count, arr);
+        MonosFree(q.arr);
+    }
 
-    free(arr);
-    
-    return r;
+    return p;
 }
 
-Poly PolyOwnMonos(size_t count, Mono *monos) {
-    if (!isSorted(count, monos)) {
-        qsort(monos, count, sizeof(Mono), MonoCompare);
+void PolyAddTo(Poly *acc, const Poly *p) {
+    if (PolyIsCoeff(acc) && PolyIsCoeff(p)) {
+        acc->coeff += p->coeff;
     }
+    else if (PolyIsCoeff(acc)) {
+        *acc = PolyAddOwn(PolyClone(p), *acc);
+    }
+    else if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p)) {
+            Mono m = (Mono) {.p = *p, .exp = 0};
 
-    Poly r = PolyAddSortedMonos(count, monos);
-
-    free(monos);
-    
-    return r;
+            PolyMergeMonos(acc, 1, &m, false);
+        }
+    }
+    else {
+        PolyMergeMonos(acc, p->size, p->arr, false);
+    }
+}
+
+/**
+ * Oznacza koniec listy wierszy w kopcu.
+ */
+#define NO_ROW SIZE_MAX
+
+/**
+ * Element kopca używanego do scalania wielu posortowanych ciągów jednomianów
+ * (wierszy). Przy mnożeniu wiersz @f$i@f$ odpowiada iloczynom @f$i@f$-tego
+ * jednomianu krótszego czynnika z kolejnymi jednomianami dłuższego,
+ * a przy sumowaniu jednomianom jednego ze składników. Wiersz wstawiany
+ * z wykładnikiem równym wykładnikowi elementu na jego ścieżce do korzenia
+ * jest dopisywany do listy tego elementu, co zmniejsza kopiec. Ten sam
+ * wykładnik może jednak wystąpić w kilku elementach kopca.
+ */
+typedef struct HeapNode {
+    poly_exp_t exp; ///< wykładnik iloczynów jednomianów
+    size_t row; ///< pierwszy wiersz na liście wierszy o tym wykładniku
+} HeapNode;
+
+/**
+ * Wstawia wiersz do kopca (minimum na szczycie, względem wykładników).
+ * Jeżeli na ścieżce do korzenia znajduje się element o tym samym wykładniku,
+ * dopisuje wiersz do jego listy zamiast wstawiać nowy element.
+ * @param[in, out] heap : kopiec
+ * @param[in, out] size : wskaźnik na liczbę elementów kopca
+ * @param[in, out] next : tablica następników na listach wierszy
+ * @param[in] row : wiersz
+ * @param[in] exp : wykładnik bieżącego iloczynu w wierszu
+ */
+static void HeapInsert(HeapNode heap[], size_t *size, size_t next[], size_t row, poly_exp_t exp) {
+    size_t i = *size;
+    while (i > 0 && heap[(i - 1) / 2].exp > exp) {
+        i = (i - 1) / 2;
+    }
+
+    if (i > 0 && heap[(i - 1) / 2].exp == exp) {
+        next[row] = heap[(i - 1) / 2].row;
+        heap[(i - 1) / 2].row = row;
+
+        return;
+    }
+
+    next[row] = NO_ROW;
+
+    for (size_t j = *size; j > i; j = (j - 1) / 2) {
+        heap[j] = heap[(j - 1) / 2];
+    }
+
+    heap[i] = (HeapNode) {.exp = exp, .row = row};
+    (*size)++;
+}
+
+/**
+ * Usuwa element ze szczytu niepustego kopca.
+ * @param[in, out] heap : kopiec
+ * @param[in, out] size : wskaźnik na liczbę elementów kopca
+ */
+static void HeapRemoveTop(HeapNode heap[], size_t *size) {
+    assert(*size > 0);
+
+    (*size)--;
+
+    HeapNode last = heap[*size];
+    size_t i = 0;
+    while (2 * i + 1 < *size) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < *size && heap[child + 1].exp < heap[child].exp) {
+            child++;
+        }
+
+        if (heap[child].exp >= last.exp) {
+            break;
+        }
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    heap[i] = last;
+}
+
+/**
+ * Sumuje wielomiany, przejmując je na własność. Jednomiany wszystkich
+ * składników są scalane jednym przejściem po kopcu, a jednomiany o równych
+ * wykładnikach są sumowane rekurencyjnie tą samą metodą.
+ * Może modyfikować zawartość tablicy @p polys, ale nie przejmuje jej pamięci.
+ * @param[in] count : liczba wielomianów
+ * @param[in] polys : tablica wielomianów
+ * @return suma wielomianów
+ */
+static Poly PolySumOwn(size_t count, Poly polys[]) {
+    poly_coeff_t coeff = 0;
+    size_t rows = 0;
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (PolyIsCoeff(&polys[i])) {
+            coeff += polys[i].coeff;
+        }
+        else {
+            total += polys[i].size;
+            polys[rows++] = polys[i];
+        }
+    }
+
+    if (rows == 0) {
+        return PolyFromCoeff(coeff);
+    }
+    else if (rows == 1) {
+        return PolyAddOwn(polys[0], PolyFromCoeff(coeff));
+    }
+    else if (rows == 2) {
+        return PolyAddOwn(PolyAddOwn(polys[0], polys[1]), PolyFromCoeff(coeff));
+    }
+
+    // Jednomiany składników są przenoszone do wyniku.
+    for (size_t row = 0; row < rows; row++) {
+        PolyUnshare(&polys[row]);
+    }
+
+    Mono *arr = MonosAlloc(total);
+
+    // Pomocnicze tablice zajmują jeden blok pamięci.
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    Poly *group = ArenaAlloc(&scratch_arena, rows * (sizeof(Poly) + sizeof(HeapNode) + 2 * sizeof(size_t)));
+    HeapNode *heap = (HeapNode *)(group + rows);
+    size_t *cursor = (size_t *)(heap + rows);
+    size_t *next = cursor + rows;
+    size_t heap_size = 0;
+
+    for (size_t row = 0; row < rows; row++) {
+        cursor[row] = 0;
+        HeapInsert(heap, &heap_size, next, row, MonoGetExp(&polys[row].arr[0]));
+    }
+
+    size_t size = 0;
+    while (heap_size > 0) {
+        poly_exp_t exp = heap[0].exp;
+        size_t group_size = 0;
+
+        // Wiersze o tym samym wykładniku mogą trafić do kilku elementów kopca.
+        while (heap_size > 0 && heap[0].exp == exp) {
+            size_t row = heap[0].row;
+
+            HeapRemoveTop(heap, &heap_size);
+
+            while (row != NO_ROW) {
+                size_t row_next = next[row];
+
+                group[group_size++] = polys[row].arr[cursor[row]].p;
+
+                cursor[row]++;
+                if (cursor[row] < polys[row].size) {
+                    HeapInsert(heap, &heap_size, next, row, MonoGetExp(&polys[row].arr[cursor[row]]));
+                }
+
+                row = row_next;
+            }
+        }
+
+        Poly sum = group_size == 1 ? group[0] : PolySumOwn(group_size, group);
+
+        if (!PolyIsZero(&sum)) {
+            arr[size++] = (Mono) {.p = sum, .exp = exp};
+        }
+    }
+
+    for (size_t row = 0; row < rows; row++) {
+        MonosFree(polys[row].arr);
+    }
+
+    ArenaRelease(&scratch_arena, mark);
+
+    if (size > 0 && size < total) {
+        arr = MonosReserve(arr, size);
+    }
+
+    return PolyAddOwn(Simplify(size, arr), PolyFromCoeff(coeff));
+}
+
+/**
+ * Sumuje listę jednomianów i tworzy z nich wielomian.
+ * Zakłada, że lista jest posortowana niemalejąco ze względu na stopień.
+ * Przejmuje na własność tablicę @p monos wraz z zawartością: jednomiany są
+ * przenoszone, a nie kopiowane, i wynik powstaje w tej samej tablicy.
+ * Ciągi jednomianów o równych wykładnikach są sumowane funkcją PolySumOwn.
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return wielomian będący sumą jednomianów
+ */
+static Poly PolyAddSortedMonos(size_t count, Mono monos[]) {
+    if (count > 0) {
+        for (size_t i = 0; i < count - 1; i++) {
+            assert(MonoGetExp(&monos[i]) <= MonoGetExp(&monos[i + 1]));
+        }
+    }
+
+    if (count == 0 || monos == NULL) {
+        MonosFree(monos);
+
+        return PolyZero();
+    }
+
+    size_t longest_run = 1;
+    for (size_t j = 0, k = 1; k <= count; k++) {
+        if (k == count || MonoGetExp(&monos[k]) != MonoGetExp(&monos[j])) {
+            longest_run = MAX(longest_run, k - j);
+            j = k;
+        }
+    }
+
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    Poly *group = NULL;
+    if (longest_run > 1) {
+        group = ArenaAlloc(&scratch_arena, longest_run * sizeof(Poly));
+    }
+
+    // Każdy ciąg zapisujemy nie dalej niż na jego początku, więc jednomiany,
+    // których jeszcze nie przetworzyliśmy, nie są nadpisywane.
+    size_t size = 0;
+    for (size_t j = 0; j < count;) {
+        poly_exp_t exp = MonoGetExp(&monos[j]);
+        size_t k = j + 1;
+        while (k < count && MonoGetExp(&monos[k]) == exp) {
+            k++;
+        }
+
+        Poly sum;
+        if (k - j == 1) {
+            sum = monos[j].p;
+        }
+        else {
+            for (size_t i = j; i < k; i++) {
+                group[i - j] = monos[i].p;
+            }
+
+            sum = PolySumOwn(k - j, group);
+        }
+
+        if (!PolyIsZero(&sum)) {
+            monos[size++] = (Mono) {.p = sum, .exp = exp};
+        }
+
+        j = k;
+    }
+
+    ArenaRelease(&scratch_arena, mark);
+
+    if (size > 0 && size < count) {
+        monos = MonosReserve(monos, size);
+    }
+
+    return Simplify(size, monos);
+}
+
+Poly PolyAddMonos(size_t count, const Mono monos[]) {
+    Mono *arr = MonosAlloc(count);
+    
+    for (size_t i = 0; i < count; i++) {
+        arr[i] = monos[i];
+    }
+
+    MonosSort(count, arr);
+
+    return PolyAddSortedMonos(count, arr);
+}
+
+Poly PolyOwnMonos(size_t count, Mono *monos) {
+    monos = MonosAdopt(count, monos);
+
+    MonosSort(count, monos);
+
+    return PolyAddSortedMonos(count, monos);
 }
 
 Poly PolyCloneMonos(size_t count, const Mono monos[]) {
-    Mono *arr = malloc(count * sizeof(Mono));
-    CHECK_PTR(arr);
+    Mono *arr = MonosAlloc(count);
     
     for (size_t i = 0; i < count; i++) {
         arr[i] = MonoClone(&monos[i]);
     }
 
-    if (!isSorted(count, arr)) {
-        qsort(arr, count, sizeof(Mono), MonoCompare);
-    }
+    MonosSort(count, arr);
+
+    return PolyAddSortedMonos(count, arr);
+}
+
+/**
+ * Sprawdza, czy wszystkie współczynniki wielomianu są liczbami, czyli czy
+ * wielomian jest liściem drzewa. Korzysta z metadanych, więc zwykle działa
+ * w czasie stałym.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return czy @p p jest wielomianem jednej zmiennej?
+ */
+static bool PolyHasCoeffTerms(const Poly *p) {
+    return PolyGetMeta(p)->depth == 1;
+}
+
+/**
+ * Liść drzewa wielomianu zapisany w dwóch równoległych tablicach: wykładników
+ * i współczynników. Zajmuje 12 zamiast 24 bajtów na jednomian, a pętle po
+ * takich tablicach kompilator może wektoryzować. Liście są rozpakowywane
+ * do areny na czas działania jednej operacji.
+ */
+typedef struct PolyLeaf {
+    size_t size; ///< liczba jednomianów
+    poly_exp_t *exps; ///< wykładniki (rosnąco)
+    poly_coeff_t *coeffs; ///< współczynniki
+} PolyLeaf;
+
+/**
+ * Rozpakowuje liść do areny.
+ * @param[in] p : wielomian, którego wszystkie współczynniki są liczbami
+ * @return liść z tymi samymi jednomianami
+ */
+static PolyLeaf PolyLeafLoad(const Poly *p) {
+    PolyLeaf leaf = {
+        .size = p->size,
+        .exps = ArenaAlloc(&scratch_arena, p->size * sizeof(poly_exp_t)),
+        .coeffs = ArenaAlloc(&scratch_arena, p->size * sizeof(poly_coeff_t))
+    };
+
+    for (size_t i = 0; i < p->size; i++) {
+        leaf.exps[i] = MonoGetExp(&p->arr[i]);
+        leaf.coeffs[i] = p->arr[i].p.coeff;
+    }
+
+    return leaf;
+}
+
+/**
+ * Tworzy wielomian z liścia, pomijając zerowe współczynniki.
+ * @param[in] leaf : liść o rosnących wykładnikach
+ * @return wielomian z jednomianami liścia
+ */
+static Poly PolyLeafStore(const PolyLeaf *leaf) {
+    size_t size = 0;
+    for (size_t i = 0; i < leaf->size; i++) {
+        size += leaf->coeffs[i] != 0;
+    }
+
+    if (size == 0) {
+        return PolyZero();
+    }
+
+    Mono *arr = MonosAlloc(size);
+
+    size_t k = 0;
+    for (size_t i = 0; i < leaf->size; i++) {
+        if (leaf->coeffs[i] != 0) {
+            arr[k++] = (Mono) {.p = PolyFromCoeff(leaf->coeffs[i]), .exp = leaf->exps[i]};
+        }
+    }
+
+    return Simplify(size, arr);
+}
+
+/**
+ * Szacuje z góry liczbę jednomianów iloczynu dwóch wielomianów.
+ * Iloczyn ma co najwyżej @f$|p| \cdot |q|@f$ jednomianów, a ich wykładniki
+ * mieszczą się w przedziale od sumy najmniejszych do sumy największych
+ * wykładników czynników.
+ * @param[in] p : wielomian @f$p@f$ (nie będący współczynnikiem)
+ * @param[in] q : wielomian @f$q@f$ (nie będący współczynnikiem)
+ * @return górne ograniczenie na liczbę jednomianów @f$p * q@f$
+ */
+static size_t PolyMulBound(const Poly *p, const Poly *q) {
+    long long span = (long long)MonoGetExp(&p->arr[p->size - 1]) + MonoGetExp(&q->arr[q->size - 1])
+                     - MonoGetExp(&p->arr[0]) - MonoGetExp(&q->arr[0]) + 1;
+
+    if (p->size > SIZE_MAX / q->size || p->size * q->size > (unsigned long long)span) {
+        return span;
+    }
+
+    return p->size * q->size;
+}
+
+/**
+ * Największa liczba iloczynów jednomianów, dla której liście są mnożone
+ * przez posortowanie wszystkich iloczynów (zob. PolyMulLeafSort).
+ */
+#define LEAF_SORT_MAX_PRODUCTS ((size_t)1 << 18)
+
+/**
+ * Najmniejsza liczba jednomianów krótszego liścia, od której iloczyny są
+ * sortowane. Przy mniejszej liczbie wierszy kopiec w PolyMulLeaf ma
+ * znikomą głębokość i jest szybszy od wypisania i posortowania iloczynów.
+ */
+#define LEAF_SORT_MIN_ROWS 64
+
+/**
+ * Największa liczba bitów wykładnika sortowana w jednym przebiegu
+ * sortowania pozycyjnego.
+ */
+#define RADIX_BITS 11
+
+/**
+ * Liczba iloczynów, poniżej której zamiast sortowania pozycyjnego
+ * używane jest sortowanie przez wstawianie.
+ */
+#define LEAF_INSERTION_MAX 32
+
+/**
+ * Mnoży dwa liście, wypisując wszystkie iloczyny jednomianów do tablic,
+ * sortując je pozycyjnie po wykładnikach i sumując iloczyny o równych
+ * wykładnikach. Pętle generujące iloczyny i rozdzielające je do kubełków
+ * przechodzą po zwartych tablicach, bez kopca. Sortowane są wykładniki
+ * pomniejszone o najmniejszy, a liczba kubełków zależy od liczby iloczynów,
+ * żeby małe iloczyny nie płaciły za zerowanie dużej tablicy kubełków.
+ * @param[in] a : liść @f$p@f$
+ * @param[in] b : liść @f$q@f$
+ * @param[out] r : liść @f$p * q@f$ z tablicami w arenie
+ */
+static void PolyMulLeafSort(const PolyLeaf *a, const PolyLeaf *b, PolyLeaf *r) {
+    size_t count = a->size * b->size;
+    poly_exp_t *exps = ArenaAlloc(&scratch_arena, count * sizeof(poly_exp_t));
+    poly_coeff_t *coeffs = ArenaAlloc(&scratch_arena, count * sizeof(poly_coeff_t));
+
+    for (size_t i = 0; i < a->size; i++) {
+        for (size_t j = 0; j < b->size; j++) {
+            exps[i * b->size + j] = a->exps[i] + b->exps[j];
+            coeffs[i * b->size + j] = a->coeffs[i] * b->coeffs[j];
+        }
+    }
+
+    if (count <= LEAF_INSERTION_MAX) {
+        for (size_t i = 1; i < count; i++) {
+            poly_exp_t exp = exps[i];
+            poly_coeff_t coeff = coeffs[i];
+            size_t j = i;
+
+            for (; j > 0 && exps[j - 1] > exp; j--) {
+                exps[j] = exps[j - 1];
+                coeffs[j] = coeffs[j - 1];
+            }
+
+            exps[j] = exp;
+            coeffs[j] = coeff;
+        }
+    }
+    else {
+        poly_exp_t min_exp = a->exps[0] + b->exps[0];
+        poly_exp_t span = a->exps[a->size - 1] + b->exps[b->size - 1] - min_exp;
+        unsigned bits = 4;
+
+        while (bits < RADIX_BITS && ((size_t)1 << bits) < count) {
+            bits++;
+        }
+
+        size_t buckets = (size_t)1 << bits;
+        poly_exp_t digit = (poly_exp_t)buckets - 1;
+        poly_exp_t *exps_tmp = ArenaAlloc(&scratch_arena, count * sizeof(poly_exp_t));
+        poly_coeff_t *coeffs_tmp = ArenaAlloc(&scratch_arena, count * sizeof(poly_coeff_t));
+        size_t *bucket = ArenaAlloc(&scratch_arena, buckets * sizeof(size_t));
+
+        for (size_t i = 0; i < count; i++) {
+            exps[i] -= min_exp;
+        }
+
+        for (unsigned shift = 0; shift < sizeof(poly_exp_t) * CHAR_BIT && (span >> shift) > 0; shift += bits) {
+            memset(bucket, 0, buckets * sizeof(size_t));
+
+            for (size_t i = 0; i < count; i++) {
+                bucket[(exps[i] >> shift) & digit]++;
+            }
+
+            size_t start = 0;
+            for (size_t d = 0; d < buckets; d++) {
+                size_t c = bucket[d];
+
+                bucket[d] = start;
+                start += c;
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                size_t pos = bucket[(exps[i] >> shift) & digit]++;
+
+                exps_tmp[pos] = exps[i];
+                coeffs_tmp[pos] = coeffs[i];
+            }
+
+            poly_exp_t *e = exps;
+            exps = exps_tmp;
+            exps_tmp = e;
+
+            poly_coeff_t *c = coeffs;
+            coeffs = coeffs_tmp;
+            coeffs_tmp = c;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            exps[i] += min_exp;
+        }
+    }
+
+    // Iloczyny o równych wykładnikach sumujemy w miejscu.
+    r->size = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (r->size > 0 && exps[r->size - 1] == exps[i]) {
+            coeffs[r->size - 1] += coeffs[i];
+        }
+        else {
+            exps[r->size] = exps[i];
+            coeffs[r->size] = coeffs[i];
+            r->size++;
+        }
+    }
+
+    r->exps = exps;
+    r->coeffs = coeffs;
+}
+
+/**
+ * Mnoży dwa liście tak jak PolyMulHeap, ale na tablicach wykładników
+ * i współczynników: iloczyny o tym samym wykładniku są sumowane w zmiennej
+ * lokalnej, a wynik powstaje w arenie i jest przepisywany do tablicy
+ * jednomianów dopiero na końcu, bez zerowych współczynników.
+ * @param[in] p : wielomian @f$p@f$, którego wszystkie współczynniki są liczbami
+ * @param[in] q : wielomian @f$q@f$, którego wszystkie współczynniki są liczbami
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulLeaf(const Poly *p, const Poly *q) {
+    if (p->size > q->size) {
+        const Poly *t = p;
+        p = q;
+        q = t;
+    }
+
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    PolyLeaf a = PolyLeafLoad(p);
+    PolyLeaf b = PolyLeafLoad(q);
+    size_t capacity = PolyMulBound(p, q);
+
+    // Sortowanie opłaca się tylko wtedy, gdy iloczyny rzadko mają równe
+    // wykładniki; przy gęstym wyniku kopiec sumuje je bez przestawiania.
+    if (a.size >= LEAF_SORT_MIN_ROWS && a.size <= LEAF_SORT_MAX_PRODUCTS / b.size
+        && capacity == a.size * b.size) {
+        PolyLeaf r;
+
+        PolyMulLeafSort(&a, &b, &r);
+
+        Poly result = PolyLeafStore(&r);
+
+        ArenaRelease(&scratch_arena, mark);
+
+        return result;
+    }
+
+    PolyLeaf r = {
+        .size = 0,
+        .exps = ArenaAlloc(&scratch_arena, capacity * sizeof(poly_exp_t)),
+        .coeffs = ArenaAlloc(&scratch_arena, capacity * sizeof(poly_coeff_t))
+    };
+    HeapNode *heap = ArenaAlloc(&scratch_arena, a.size * sizeof(HeapNode));
+    size_t *cursor = ArenaAlloc(&scratch_arena, a.size * sizeof(size_t));
+    size_t *next = ArenaAlloc(&scratch_arena, a.size * sizeof(size_t));
+    size_t heap_size = 0;
+
+    cursor[0] = 0;
+    HeapInsert(heap, &heap_size, next, 0, a.exps[0] + b.exps[0]);
+
+    while (heap_size > 0) {
+        poly_exp_t exp = heap[0].exp;
+        size_t row = heap[0].row;
+        poly_coeff_t sum = 0;
+
+        HeapRemoveTop(heap, &heap_size);
+
+        while (row != NO_ROW) {
+            size_t row_next = next[row];
+
+            sum += a.coeffs[row] * b.coeffs[cursor[row]];
+
+            if (cursor[row] == 0 && row + 1 < a.size) {
+                cursor[row + 1] = 0;
+                HeapInsert(heap, &heap_size, next, row + 1, a.exps[row + 1] + b.exps[0]);
+            }
+
+            cursor[row]++;
+            if (cursor[row] < b.size) {
+                HeapInsert(heap, &heap_size, next, row, a.exps[row] + b.exps[cursor[row]]);
+            }
+
+            row = row_next;
+        }
+
+        if (r.size > 0 && r.exps[r.size - 1] == exp) {
+            r.coeffs[r.size - 1] += sum;
+        }
+        else {
+            r.exps[r.size] = exp;
+            r.coeffs[r.size] = sum;
+            r.size++;
+        }
+    }
+
+    Poly result = PolyLeafStore(&r);
+
+    ArenaRelease(&scratch_arena, mark);
+
+    return result;
+}
+
+/**
+ * Mnoży dwa wielomiany nie będące współczynnikami.
+ * Iloczyny jednomianów są generowane w kolejności rosnących wykładników
+ * przy pomocy kopca wierszy (po jednym wierszu na każdy jednomian krótszego
+ * czynnika), dzięki czemu wynik powstaje od razu posortowany, w jednej tablicy.
+ * Wiersz @f$i + 1@f$ trafia do kopca dopiero po zużyciu pierwszego iloczynu
+ * z wiersza @f$i@f$, więc kopiec pozostaje mały.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulHeap(const Poly *p, const Poly *q) {
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    if (PolyHasCoeffTerms(p) && PolyHasCoeffTerms(q)) {
+        return PolyMulLeaf(p, q);
+    }
+
+    if (p->size > q->size) {
+        const Poly *t = p;
+        p = q;
+        q = t;
+    }
+
+    size_t capacity = PolyMulBound(p, q);
+    Mono *arr = MonosAlloc(capacity);
+
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    HeapNode *heap = ArenaAlloc(&scratch_arena, p->size * sizeof(HeapNode));
+    size_t *cursor = ArenaAlloc(&scratch_arena, p->size * sizeof(size_t));
+    size_t *next = ArenaAlloc(&scratch_arena, p->size * sizeof(size_t));
+    size_t heap_size = 0;
+
+    cursor[0] = 0;
+    HeapInsert(heap, &heap_size, next, 0, MonoGetExp(&p->arr[0]) + MonoGetExp(&q->arr[0]));
+
+    size_t size = 0;
+    while (heap_size > 0) {
+        poly_exp_t exp = heap[0].exp;
+        size_t row = heap[0].row;
+
+        HeapRemoveTop(heap, &heap_size);
+
+        if (size == 0 || MonoGetExp(&arr[size - 1]) != exp) {
+            if (size > 0 && PolyIsZero(&arr[size - 1].p)) {
+                size--;
+            }
+
+            arr[size] = (Mono) {.p = PolyZero(), .exp = exp};
+
+            size++;
+        }
+
+        Poly *r = &arr[size - 1].p;
+
+        while (row != NO_ROW) {
+            size_t row_next = next[row];
+            const Poly *p_c = &p->arr[row].p;
+            const Poly *q_c = &q->arr[cursor[row]].p;
+
+            PolyFma(r, p_c, q_c);
+
+            if (cursor[row] == 0 && row + 1 < p->size) {
+                cursor[row + 1] = 0;
+                HeapInsert(heap, &heap_size, next, row + 1,
+                           MonoGetExp(&p->arr[row + 1]) + MonoGetExp(&q->arr[0]));
+            }
+
+            cursor[row]++;
+            if (cursor[row] < q->size) {
+                HeapInsert(heap, &heap_size, next, row,
+                           MonoGetExp(&p->arr[row]) + MonoGetExp(&q->arr[cursor[row]]));
+            }
+
+            row = row_next;
+        }
+    }
+
+    ArenaRelease(&scratch_arena, mark);
+
+    if (size > 0 && PolyIsZero(&arr[size - 1].p)) {
+        size--;
+    }
+
+    if (size == 0) {
+        MonosFree(arr);
+
+        return PolyZero();
+    }
+
+    if (size < capacity) {
+        arr = MonosReserve(arr, size);
+    }
+
+    return Simplify(size, arr);
+}
+
+/**
+ * Mnoży wielomian przez niezerowy współczynnik, przejmując go na własność
+ * i modyfikując w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$p * c@f$
+ */
+static Poly PolyScaleOwn(Poly p, poly_coeff_t c) {
+    if (PolyIsCoeff(&p)) {
+        return PolyFromCoeff(p.coeff * c);
+    }
+    else if (c == 1) {
+        return p;
+    }
+
+    PolyUnshare(&p);
+
+    for (size_t i = 0; i < p.size; i++) {
+        p.arr[i].p = PolyScaleOwn(p.arr[i].p, c);
+    }
+
+    return Simplify(p.size, p.arr);
+}
+
+/**
+ * Kończy grupę iloczynów o jednym wykładniku przy podnoszeniu do kwadratu:
+ * zamienia sumę iloczynów różnych jednomianów na jej podwojenie powiększone
+ * o kwadrat jednomianu z przekątnej.
+ * @param[in, out] cross : suma iloczynów różnych jednomianów
+ * @param[in] diagonal : kwadrat jednomianu z przekątnej lub zero
+ */
+static void PolySqrFinish(Poly *cross, Poly diagonal) {
+    if (!PolyIsZero(cross)) {
+        *cross = PolyScaleOwn(*cross, 2);
+    }
+
+    *cross = PolyAddOwn(*cross, diagonal);
+}
+
+/**
+ * Podnosi do kwadratu wielomian nie będący współczynnikiem, tak jak
+ * PolyMulHeap, ale wiersz @f$i@f$ zaczyna się od jednomianu @f$i@f$, więc
+ * kopiec przechodzi tylko po iloczynach @f$p_i p_j@f$ dla @f$i \leq j@f$.
+ * Iloczyny różnych jednomianów o tym samym wykładniku są sumowane,
+ * a suma jest podwajana raz na cały wykładnik. Iloczyn z przekątnej
+ * (jest co najwyżej jeden na wykładnik) liczy PolySqr.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p^2@f$
+ */
+static Poly PolySqrHeap(const Poly *p) {
+    assert(!PolyIsCoeff(p));
+
+    size_t capacity = PolyMulBound(p, p);
+    Mono *arr = MonosAlloc(capacity);
+
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    HeapNode *heap = ArenaAlloc(&scratch_arena, p->size * sizeof(HeapNode));
+    size_t *cursor = ArenaAlloc(&scratch_arena, p->size * sizeof(size_t));
+    size_t *next = ArenaAlloc(&scratch_arena, p->size * sizeof(size_t));
+    size_t heap_size = 0;
+
+    cursor[0] = 0;
+    HeapInsert(heap, &heap_size, next, 0, 2 * MonoGetExp(&p->arr[0]));
+
+    Poly diagonal = PolyZero();
+    size_t size = 0;
+    while (heap_size > 0) {
+        poly_exp_t exp = heap[0].exp;
+        size_t row = heap[0].row;
+
+        HeapRemoveTop(heap, &heap_size);
+
+        if (size == 0 || MonoGetExp(&arr[size - 1]) != exp) {
+            if (size > 0) {
+                PolySqrFinish(&arr[size - 1].p, diagonal);
+                diagonal = PolyZero();
+
+                if (PolyIsZero(&arr[size - 1].p)) {
+                    size--;
+                }
+            }
+
+            arr[size] = (Mono) {.p = PolyZero(), .exp = exp};
+
+            size++;
+        }
+
+        while (row != NO_ROW) {
+            size_t row_next = next[row];
+
+            if (cursor[row] == row) {
+                diagonal = PolySqr(&p->arr[row].p);
+
+                if (row + 1 < p->size) {
+                    cursor[row + 1] = row + 1;
+                    HeapInsert(heap, &heap_size, next, row + 1, 2 * MonoGetExp(&p->arr[row + 1]));
+                }
+            }
+            else {
+                PolyFma(&arr[size - 1].p, &p->arr[row].p, &p->arr[cursor[row]].p);
+            }
+
+            cursor[row]++;
+            if (cursor[row] < p->size) {
+                HeapInsert(heap, &heap_size, next, row,
+                           MonoGetExp(&p->arr[row]) + MonoGetExp(&p->arr[cursor[row]]));
+            }
+
+            row = row_next;
+        }
+    }
+
+    ArenaRelease(&scratch_arena, mark);
+
+    PolySqrFinish(&arr[size - 1].p, diagonal);
+    if (PolyIsZero(&arr[size - 1].p)) {
+        size--;
+    }
+
+    if (size == 0) {
+        MonosFree(arr);
+
+        return PolyZero();
+    }
+
+    if (size < capacity) {
+        arr = MonosReserve(arr, size);
+    }
+
+    return Simplify(size, arr);
+}
+
+/**
+ * Maksymalna liczba zmiennych, dla której stosujemy podstawienie Kroneckera.
+ */
+#define KRONECKER_MAX_VARS 16
+
+/**
+ * Maksymalna długość tablicy współczynników iloczynu przy podstawieniu
+ * Kroneckera.
+ */
+#define KRONECKER_MAX_LENGTH (1 << 24)
+
+/**
+ * Minimalna liczba iloczynów jednomianów, od której opłaca się pakować
+ * czynniki do tablic współczynników.
+ */
+#define KRONECKER_MIN_WORK 256
+
+/**
+ * Dopuszczalny stosunek szacowanej liczby mnożeń współczynników w tablicach
+ * do liczby iloczynów niezerowych jednomianów.
+ */
+#define KRONECKER_MAX_RATIO 32
+
+/**
+ * Kształt wielomianu: zakresy wykładników kolejnych zmiennych
+ * i liczba niezerowych współczynników liczbowych.
+ */
+typedef struct PolyShape {
+    size_t vars; ///< liczba zmiennych (głębokość drzewa jednomianów)
+    size_t terms; ///< liczba niezerowych współczynników liczbowych
+    size_t zero_from; ///< najmniejszy indeks zmiennej, która w pewnym jednomianie nie występuje
+    poly_exp_t lo[KRONECKER_MAX_VARS]; ///< najmniejsze wykładniki zmiennych
+    poly_exp_t hi[KRONECKER_MAX_VARS]; ///< największe wykładniki zmiennych
+} PolyShape;
+
+/**
+ * Uzupełnia kształt o jednomiany wielomianu @p p, który jest współczynnikiem
+ * przy zmiennej o indeksie @p var.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej
+ * @param[in, out] shape : kształt
+ * @return czy liczba zmiennych nie przekracza KRONECKER_MAX_VARS?
+ */
+static bool PolyShapeAux(const Poly *p, size_t var, PolyShape *shape) {
+    if (PolyIsCoeff(p)) {
+        shape->terms++;
+        shape->zero_from = MIN(shape->zero_from, var);
+
+        return true;
+    }
+
+    if (var >= KRONECKER_MAX_VARS) {
+        return false;
+    }
+
+    shape->vars = MAX(shape->vars, var + 1);
+    shape->lo[var] = MIN(shape->lo[var], MonoGetExp(&p->arr[0]));
+    shape->hi[var] = MAX(shape->hi[var], MonoGetExp(&p->arr[p->size - 1]));
+
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyShapeAux(&p->arr[i].p, var + 1, shape)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Wyznacza kształt wielomianu, tzn. to, co dla kolejnych zmiennych zwracałaby
+ * funkcja PolyDegBy, a także najmniejsze wykładniki i liczbę współczynników.
+ * Zmienne, które w jakimś jednomianie nie występują, mają najmniejszy
+ * wykładnik równy zeru.
+ * @param[in] p : wielomian
+ * @param[out] shape : kształt
+ * @return czy liczba zmiennych nie przekracza KRONECKER_MAX_VARS?
+ */
+static bool PolyGetShape(const Poly *p, PolyShape *shape) {
+    shape->vars = 0;
+    shape->terms = 0;
+    shape->zero_from = KRONECKER_MAX_VARS;
+    for (size_t i = 0; i < KRONECKER_MAX_VARS; i++) {
+        shape->lo[i] = INT_MAX;
+        shape->hi[i] = 0;
+    }
+
+    if (!PolyShapeAux(p, 0, shape)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < KRONECKER_MAX_VARS; i++) {
+        if (i >= shape->zero_from || i >= shape->vars) {
+            shape->lo[i] = 0;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Wpisuje współczynniki wielomianu do tablicy według podstawienia Kroneckera:
+ * jednomian @f$c x_0^{e_0} x_1^{e_1} \ldots@f$ trafia pod indeks
+ * @f$\sum_i (e_i - lo_i) \cdot stride_i@f$.
+ * @param[in] p : wielomian będący współczynnikiem przy zmiennej o indeksie @p var
+ * @param[in] var : indeks zmiennej
+ * @param[in] offset : indeks wyznaczony przez wykładniki poprzednich zmiennych
+ * @param[in] lo : najmniejsze wykładniki zmiennych
+ * @param[in] stride : mnożniki kolejnych zmiennych
+ * @param[out] dst : tablica współczynników
+ */
+static void PolyKroneckerPack(const Poly *p, size_t var, size_t offset, const poly_exp_t lo[],
+                              const size_t stride[], dense_coeff_t dst[]) {
+    if (PolyIsCoeff(p)) {
+        dst[offset] = p->coeff;
+    }
+    else {
+        for (size_t i = 0; i < p->size; i++) {
+            PolyKroneckerPack(&p->arr[i].p, var + 1, offset + (MonoGetExp(&p->arr[i]) - lo[var]) * stride[var],
+                              lo, stride, dst);
+        }
+    }
+}
+
+/**
+ * Odtwarza wielomian z fragmentu tablicy współczynników wypełnionej według
+ * podstawienia Kroneckera. Fragment zaczyna się od indeksu @p offset i opisuje
+ * współczynnik przy zmiennej o indeksie @p var.
+ * @param[in] src : tablica współczynników
+ * @param[in] length : długość tablicy
+ * @param[in] offset : początek fragmentu
+ * @param[in] var : indeks zmiennej
+ * @param[in] vars : liczba zmiennych
+ * @param[in] lo : najmniejsze wykładniki zmiennych
+ * @param[in] base : liczba możliwych wykładników kolejnych zmiennych
+ * @param[in] stride : mnożniki kolejnych zmiennych
+ * @return odtworzony wielomian
+ */
+static Poly PolyKroneckerUnpack(const dense_coeff_t src[], size_t length, size_t offset, size_t var, size_t vars,
+                                const poly_exp_t lo[], const size_t base[], const size_t stride[]) {
+    if (var == vars) {
+        return PolyFromCoeff(src[offset]);
+    }
+
+    size_t count = base[var];
+    if (offset + (count - 1) * stride[var] >= length) {
+        count = (length - 1 - offset) / stride[var] + 1;
+    }
+
+    Mono *arr = MonosAlloc(count);
+
+    size_t size = 0;
+    for (size_t e = 0; e < count; e++) {
+        Poly c = PolyKroneckerUnpack(src, length, offset + e * stride[var], var + 1, vars, lo, base, stride);
+
+        if (!PolyIsZero(&c)) {
+            arr[size] = (Mono) {.p = c, .exp = lo[var] + e};
+
+            size++;
+        }
+    }
+
+    if (size == 0) {
+        MonosFree(arr);
+
+        return PolyZero();
+    }
+
+    if (size < count) {
+        arr = MonosReserve(arr, size);
+    }
+
+    return Simplify(size, arr);
+}
+
+/**
+ * Mnoży dwa wielomiany nie będące współczynnikami przy pomocy podstawienia
+ * Kroneckera, o ile jest ono bezpieczne i opłacalne. Zakresy wykładników
+ * każdej zmiennej iloczynu są znane z góry (sumy zakresów czynników), więc
+ * wielomian wielu zmiennych można zapisać jako wielomian jednej zmiennej,
+ * pomnożyć gęsto i rozpakować bez kolizji wykładników. Jeżeli @p p i @p q
+ * wskazują na ten sam wielomian, jest on pakowany raz i podnoszony do kwadratu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] r : @f$p * q@f$, jeżeli podstawienie zostało zastosowane
+ * @return czy podstawienie zostało zastosowane?
+ */
+static bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *r) {
+    PolyShape shape_p, shape_q;
+
+    if (!PolyGetShape(p, &shape_p)) {
+        return false;
+    }
+
+    if (p == q) {
+        shape_q = shape_p;
+    }
+    else if (!PolyGetShape(q, &shape_q)) {
+        return false;
+    }
+
+    if (shape_p.terms * shape_q.terms < KRONECKER_MIN_WORK) {
+        return false;
+    }
+
+    size_t vars = MAX(shape_p.vars, shape_q.vars);
+    size_t base[KRONECKER_MAX_VARS];
+    size_t stride[KRONECKER_MAX_VARS];
+    poly_exp_t lo[KRONECKER_MAX_VARS];
+
+    size_t length = 1;
+    for (size_t i = vars; i-- > 0;) {
+        base[i] = (size_t)(shape_p.hi[i] - shape_p.lo[i]) + (shape_q.hi[i] - shape_q.lo[i]) + 1;
+        stride[i] = length;
+        lo[i] = shape_p.lo[i] + shape_q.lo[i];
+
+        if (base[i] > KRONECKER_MAX_LENGTH / length) {
+            return false;
+        }
+
+        length *= base[i];
+    }
+
+    size_t length_p = 1;
+    size_t length_q = 1;
+    for (size_t i = 0; i < vars; i++) {
+        length_p += (shape_p.hi[i] - shape_p.lo[i]) * stride[i];
+        length_q += (shape_q.hi[i] - shape_q.lo[i]) * stride[i];
+    }
+
+    double dense_work = p == q ? DenseSqrWork(length_p, shape_p.terms)
+                               : DenseMulWork(length_p, shape_p.terms, length_q, shape_q.terms);
+    double sparse_work = p == q ? (double)shape_p.terms * (shape_p.terms + 1) / 2
+                                : (double)shape_p.terms * shape_q.terms;
+    if (dense_work > KRONECKER_MAX_RATIO * sparse_work) {
+        return false;
+    }
+
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    dense_coeff_t *a = ArenaAlloc(&scratch_arena, (length_p + length_q) * sizeof(dense_coeff_t));
+    dense_coeff_t *b = a + length_p;
+    dense_coeff_t *c = ArenaAlloc(&scratch_arena, (length_p + length_q - 1) * sizeof(dense_coeff_t));
+
+    memset(a, 0, (length_p + length_q) * sizeof(dense_coeff_t));
+
+    PolyKroneckerPack(p, 0, 0, shape_p.lo, stride, a);
+
+    if (p == q) {
+        DenseSqr(a, length_p, c);
+    }
+    else {
+        PolyKroneckerPack(q, 0, 0, shape_q.lo, stride, b);
+
+        DenseMul(a, length_p, b, length_q, c);
+    }
+
+    *r = PolyKroneckerUnpack(c, length_p + length_q - 1, 0, 0, vars, lo, base, stride);
+
+    ArenaRelease(&scratch_arena, mark);
+
+    return true;
+}
+
+/**
+ * Liczba trwających wywołań funkcji, których wyniki są zapamiętywane.
+ * Pamięć podręczna (zob. poly_cache.h) jest używana tylko przez wywołania
+ * spoza biblioteki, a nie przez wywołania pomocnicze wewnątrz innych operacji.
+ * Licznik dotyczy wywołań bieżącego wątku.
+ */
+static _Thread_local unsigned cached_calls = 0;
+
+/**
+ * Podnosi do kwadratu wielomian niebędący współczynnikiem, bez użycia
+ * pamięci podręcznej.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p^2@f$
+ */
+static Poly PolySqrCompute(const Poly *p) {
+    Poly r;
+
+    if (PolyMulKronecker(p, p, &r)) {
+        return r;
+    }
+
+    return PolySqrHeap(p);
+}
+
+Poly PolySqr(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(p->coeff * p->coeff);
+    }
+    else if (cached_calls > 0) {
+        return PolySqrCompute(p);
+    }
+
+    Poly r;
+
+    if (PolyCacheLookup(POLY_CACHE_MUL, p, 1, p, 0, &r)) {
+        return r;
+    }
+
+    cached_calls++;
+    r = PolySqrCompute(p);
+    cached_calls--;
 
-    Poly r = PolyAddSortedMonos(count, arr);
+    PolyCacheStore(POLY_CACHE_MUL, p, 1, p, 0, &r);
 
-    free(arr);
-    
     return r;
 }
 
@@ -368,31 +1896,25 @@ Poly PolyMul(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
         return PolyFromCoeff(p->coeff * q-> coeff);
     }
-    else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {       
-        Mono *monos = malloc(q->size * sizeof(Mono));
-        CHECK_PTR(monos);
-
-        Poly r = PolyZero();
-
-        for (size_t i_p = 0; i_p < p->size; i_p++) {
-            Mono *m_p = &(p->arr[i_p]);
-
-            for (size_t i_q = 0; i_q < q->size; i_q++) {
-                Mono *m_q = &(q->arr[i_q]);
-
-                monos[i_q] = (Mono) {.p = PolyMul(&m_p->p, &m_q->p), .exp = MonoGetExp(m_p) + MonoGetExp(m_q)};
-            }
-
-            Poly s = PolyAddSortedMonos(q->size, monos);
-            Poly t = PolyAdd(&r, &s);
+    else if (p->arr == q->arr) {
+        return PolySqr(p);
+    }
+    else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
+        Poly r;
 
-            PolyDestroy(&r);
-            PolyDestroy(&s);
+        if (cached_calls == 0 && PolyCacheLookup(POLY_CACHE_MUL, p, 1, q, 0, &r)) {
+            return r;
+        }
 
-            r = t;
+        cached_calls++;
+        if (!PolyMulKronecker(p, q, &r)) {
+            r = PolyMulHeap(p, q);
         }
+        cached_calls--;
 
-        free(monos);
+        if (cached_calls == 0) {
+            PolyCacheStore(POLY_CACHE_MUL, p, 1, q, 0, &r);
+        }
 
         return r;
     }
@@ -402,8 +1924,7 @@ Poly PolyMul(const Poly *p, const Poly *q) {
                 return PolyZero();
             }
 
-            Mono *monos = malloc(p->size * sizeof(Mono));
-            CHECK_PTR(monos);
+            Mono *monos = MonosAlloc(p->size);
 
             size_t k = 0;
             for (size_t i = 0; i < p->size; i++) {
@@ -416,16 +1937,106 @@ Poly PolyMul(const Poly *p, const Poly *q) {
                 }
             }
 
-            Poly r = PolyAddSortedMonos(k, monos);
+            return PolyAddSortedMonos(k, monos);
+        }
+        else {
+            return PolyMul(q, p);
+        }
+    }
+}
+
+void PolyFma(Poly *acc, const Poly *p, const Poly *q) {
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        Poly c = PolyFromCoeff(p->coeff * q->coeff);
+
+        PolyAddTo(acc, &c);
+    }
+    else {
+        *acc = PolyAddOwn(*acc, PolyMul(p, q));
+    }
+}
+
+Poly PolyMulOwn(Poly p, Poly q) {
+    if (PolyIsCoeff(&p) && !PolyIsCoeff(&q)) {
+        return PolyMulOwn(q, p);
+    }
+    else if (PolyIsCoeff(&q)) {
+        if (PolyIsZero(&q)) {
+            PolyDestroy(&p);
 
-            free(monos);
+            return PolyZero();
+        }
 
-            return r;
+        return PolyScaleOwn(p, q.coeff);
+    }
+
+    Poly r = PolyMul(&p, &q);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    return r;
+}
+
+/**
+ * Podnosi do potęgi wielomian niebędący współczynnikiem, bez użycia
+ * pamięci podręcznej.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] e : wykładnik @f$e > 0@f$
+ * @return @f$p^e@f$
+ */
+static Poly PolyPowCompute(const Poly *p, poly_exp_t e) {
+    int bit = 30;
+    while ((e >> bit) == 0) {
+        bit--;
+    }
+
+    Poly r = PolyClone(p);
+
+    while (bit-- > 0) {
+        Poly t = PolySqr(&r);
+
+        PolyDestroy(&r);
+
+        if ((e >> bit) & 1) {
+            r = PolyMul(&t, p);
+
+            PolyDestroy(&t);
         }
         else {
-            return PolyMul(q, p);
+            r = t;
         }
     }
+
+    return r;
+}
+
+Poly PolyPow(const Poly *p, poly_exp_t e) {
+    assert(e >= 0);
+
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffPower(p->coeff, e));
+    }
+    else if (e == 0) {
+        return PolyFromCoeff(1);
+    }
+    else if (cached_calls > 0) {
+        return PolyPowCompute(p, e);
+    }
+
+    Poly r;
+
+    if (PolyCacheLookup(POLY_CACHE_POW, p, 0, NULL, e, &r)) {
+        return r;
+    }
+
+    cached_calls++;
+    r = PolyPowCompute(p, e);
+    cached_calls--;
+
+    PolyCacheStore(POLY_CACHE_POW, p, 0, NULL, e, &r);
+
+    return r;
 }
 
 /**
@@ -437,27 +2048,32 @@ static void PolyNegAux(Poly *p) {
         p->coeff *= -1;
     }
     else {
+        PolyUnshare(p);
+
         for (size_t i = 0; i < p->size; i++) {
             PolyNegAux(&(p->arr[i].p));
         }
+
+        PolyMetaUpdate(p);
     }
 }
 
 Poly PolyNeg(const Poly *p) {
-    Poly r = PolyClone(p);
+    return PolyCloneSigned(p, true);
+}
 
-    PolyNegAux(&r);
+Poly PolyNegOwn(Poly p) {
+    PolyNegAux(&p);
 
-    return r;
+    return p;
 }
 
 Poly PolySub(const Poly *p, const Poly *q) {
-    Poly neg_q = PolyNeg(q);
-    Poly r = PolyAdd(p, &neg_q);
-
-    PolyDestroy(&neg_q);
+    return PolyMerge(p, q, true);
+}
 
-    return r;
+Poly PolySubOwn(Poly p, Poly q) {
+    return PolyAddOwn(p, PolyNegOwn(q));
 }
 
 poly_exp_t PolyDegBy(const Poly *p, size_t var_idx) {
@@ -465,12 +2081,10 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx) {
         return PolyIsZero(p) ? -1 : 0;
     }
     else if (var_idx == 0) {
-        poly_exp_t deg = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            deg = MAX(deg, MonoGetExp(&p->arr[i]));
-        }
-
-        return deg;
+        return MonoGetExp(&p->arr[p->size - 1]);
+    }
+    else if (var_idx >= PolyGetMeta(p)->depth) {
+        return 0;
     }
     else {
         poly_exp_t deg = 0;
@@ -487,13 +2101,25 @@ poly_exp_t PolyDeg(const Poly *p) {
         return PolyIsZero(p) ? -1 : 0;
     }
     else {
-        poly_exp_t deg = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            deg = MAX(deg, MonoGetExp(&p->arr[i]) + PolyDeg(&(&p->arr[i])->p));
-        }
+        return PolyGetMeta(p)->deg;
+    }
+}
 
-        return deg;
+size_t PolyTerms(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyIsZero(p) ? 0 : 1;
     }
+    else {
+        return PolyGetMeta(p)->terms;
+    }
+}
+
+size_t PolyDepth(const Poly *p) {
+    return PolyIsCoeff(p) ? 0 : PolyGetMeta(p)->depth;
+}
+
+size_t PolyMemory(const Poly *p) {
+    return PolyIsCoeff(p) ? 0 : PolyGetMeta(p)->bytes;
 }
 
 bool PolyIsEq(const Poly *p, const Poly *q) {
@@ -501,6 +2127,30 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
         return p->coeff == q->coeff;
     }
     else if (!PolyIsCoeff(p) && !PolyIsCoeff(q) && p->size == q->size) {
+        if (p->arr == q->arr) {
+            return true;
+        }
+        else if (MonosMeta(p->arr)->interned && MonosMeta(q->arr)->interned) {
+            return false;
+        }
+
+        const PolyMeta *p_meta = PolyGetMeta(p);
+        const PolyMeta *q_meta = PolyGetMeta(q);
+
+        if (p_meta->hash != q_meta->hash || p_meta->terms != q_meta->terms) {
+            return false;
+        }
+        else if (p_meta->depth == 1 && q_meta->depth == 1) {
+            // Liście porównujemy jedną pętlą, bez rekurencji dla współczynników.
+            for (size_t i = 0; i < p->size; i++) {
+                if (p->arr[i].exp != q->arr[i].exp || p->arr[i].p.coeff != q->arr[i].p.coeff) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
         for (size_t i = 0; i < p->size; i++) {
             if ((MonoGetExp(&p->arr[i]) != MonoGetExp(&q->arr[i]))
                 || !PolyIsEq(&(&p->arr[i])->p, &(&q->arr[i])->p)) {
@@ -515,234 +2165,438 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
     }
 }
 
-Poly PolyAt(const Poly *p, poly_coeff_t x) {
-    if (PolyIsCoeff(p)) {
-        return PolyClone(p);
+/**
+ * Wylicza wartość wielomianu jednej zmiennej schematem Hornera.
+ * Kolejne jednomiany są przetwarzane od najwyższego wykładnika, a potęga
+ * @f$x@f$ jest podnoszona tylko do różnicy sąsiednich wykładników.
+ * @param[in] p : wielomian, którego wszystkie współczynniki są liczbami
+ * @param[in] x : wartość argumentu
+ * @return @f$p(x)@f$
+ */
+static poly_coeff_t PolyAtCoeff(const Poly *p, poly_coeff_t x) {
+    poly_coeff_t value = 0;
+
+    for (size_t i = p->size; i > 0; i--) {
+        poly_exp_t gap = MonoGetExp(&p->arr[i - 1]) - (i > 1 ? MonoGetExp(&p->arr[i - 2]) : 0);
+
+        value = (value + p->arr[i - 1].p.coeff) * CoeffPower(x, gap);
     }
-    else {
-        Poly q = PolyZero();
 
-        for (size_t i = 0; i < p->size; i++) {
-            Poly c = PolyFromCoeff(Exp(x, MonoGetExp(&p->arr[i])));
-            c = PolyMul(&c, &(&p->arr[i])->p);
+    return value;
+}
 
-            Poly r = PolyAdd(&q, &c);
-            
-            PolyDestroy(&c);
-            PolyDestroy(&q);
+/**
+ * Wylicza wartości wielomianu jednej zmiennej w wielu punktach naraz.
+ * Jednomiany są przetwarzane schematem Hornera od najwyższego wykładnika,
+ * a dla każdego z nich pętla wewnętrzna przechodzi po wszystkich punktach.
+ * @param[in] p : wielomian, którego wszystkie współczynniki są liczbami
+ * @param[in] xs : punkty
+ * @param[in] n : liczba punktów
+ * @param[out] values : wartości @f$p@f$ w kolejnych punktach
+ */
+static void PolyAtCoeffMany(const Poly *p, const poly_coeff_t xs[], size_t n, poly_coeff_t values[]) {
+    for (size_t j = 0; j < n; j++) {
+        values[j] = 0;
+    }
 
-            q = r;
-        }
+    for (size_t i = p->size; i > 0; i--) {
+        poly_exp_t gap = MonoGetExp(&p->arr[i - 1]) - (i > 1 ? MonoGetExp(&p->arr[i - 2]) : 0);
+        poly_coeff_t c = p->arr[i - 1].p.coeff;
 
-        return q;
+        if (gap == 0) {
+            for (size_t j = 0; j < n; j++) {
+                values[j] += c;
+            }
+        }
+        else if (gap == 1) {
+            for (size_t j = 0; j < n; j++) {
+                values[j] = (values[j] + c) * xs[j];
+            }
+        }
+        else {
+            for (size_t j = 0; j < n; j++) {
+                values[j] = (values[j] + c) * CoeffPower(xs[j], gap);
+            }
+        }
     }
 }
 
 /**
- * Zamienia wielomian @f$p(x_0, x_1, \dots)@f$ na wielomian 
- * @f$p(x_0, x_1, \dots, x_{k-1}, 0, 0, \dots)@f$. 
- * @param[in] p : wielomian
- * @param[in] k : liczba niezerowych zmiennych
+ * Wylicza wartość wielomianu o współczynnikach wielomianowych w punkcie.
+ * Jednomiany są przetwarzane od najniższego wykładnika, a bieżąca potęga
+ * @f$x@f$ jest mnożona przez potęgę różnicy sąsiednich wykładników.
+ * Przeskalowane kopie współczynników są sumowane jednym scaleniem.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] x : wartość argumentu
+ * @param[in] terms : pamięć pomocnicza na @p p->size wielomianów
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
  */
-static void PolyTrim(Poly *p, size_t k) {
-    if (k > 0 && !PolyIsCoeff(p)) {
-        for (size_t i = 0; i < p->size; i++) {
-            PolyTrim(&((p->arr[i]).p), k - 1);
+static Poly PolyAtTerms(const Poly *p, poly_coeff_t x, Poly terms[]) {
+    size_t count = 0;
+    poly_exp_t exp = 0;
+    poly_coeff_t power = 1;
+
+    for (size_t i = 0; i < p->size && power != 0; i++) {
+        power *= CoeffPower(x, MonoGetExp(&p->arr[i]) - exp);
+        exp = MonoGetExp(&p->arr[i]);
+
+        if (power != 0) {
+            terms[count++] = PolyScaleOwn(PolyClone(&p->arr[i].p), power);
         }
+    }
+
+    return PolySumOwn(count, terms);
+}
 
-        *p = Simplify(p->size, p->arr);
+Poly PolyAt(const Poly *p, poly_coeff_t x) {
+    if (PolyIsCoeff(p)) {
+        return PolyClone(p);
+    }
+    else if (PolyHasCoeffTerms(p)) {
+        return PolyFromCoeff(PolyAtCoeff(p, x));
     }
-    else if (k == 0 && !PolyIsCoeff(p)) {
-        if (p->arr[0].exp == 0) {
-            Mono m = MonoClone(&(p->arr[0]));
 
-            for (size_t i = 0; i < p->size; i++) {
-                MonoDestroy(&(p->arr[i]));
-            }
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    Poly *terms = ArenaAlloc(&scratch_arena, p->size * sizeof(Poly));
+
+    Poly q = PolyAtTerms(p, x, terms);
 
-            free(p->arr);
+    ArenaRelease(&scratch_arena, mark);
 
-            PolyTrim(&(m.p), 0);
-            
-            p->arr = NULL;
-            p->coeff = m.p.coeff;
+    return q;
+}
+
+void PolyAtMany(const Poly *p, const poly_coeff_t xs[], size_t n, Poly out[]) {
+    if (PolyIsCoeff(p)) {
+        for (size_t j = 0; j < n; j++) {
+            out[j] = PolyFromCoeff(p->coeff);
         }
-        else {
-            for (size_t i = 0; i < p->size; i++) {
-                MonoDestroy(&(p->arr[i]));
-            }
+    }
+    else if (PolyHasCoeffTerms(p)) {
+        ArenaMark mark = ArenaGetMark(&scratch_arena);
+        poly_coeff_t *values = ArenaAlloc(&scratch_arena, n * sizeof(poly_coeff_t));
+
+        PolyAtCoeffMany(p, xs, n, values);
 
-            free(p->arr);
+        for (size_t j = 0; j < n; j++) {
+            out[j] = PolyFromCoeff(values[j]);
+        }
+
+        ArenaRelease(&scratch_arena, mark);
+    }
+    else {
+        ArenaMark mark = ArenaGetMark(&scratch_arena);
+        Poly *terms = ArenaAlloc(&scratch_arena, p->size * sizeof(Poly));
 
-            p->arr = NULL;
-            p->coeff = 0;
+        for (size_t j = 0; j < n; j++) {
+            out[j] = PolyAtTerms(p, xs[j], terms);
         }
+
+        ArenaRelease(&scratch_arena, mark);
     }
 }
 
-/**
- * Składa wielomian @f$p@f$ z wielomianami @f$q_0, q_1, \dots, q_{k-1}@f$.
- * Zakłada, że @f$p@f$ jest postaci @f$a\cdot\prod_{i=0}^n x_i^{t_i}@f$
- * oraz @f$k \geq 1@f$.
- * @param[in] p : wielomian @f$p@f$
- * @param[in] k : liczba wielomianów składanych z @f$p@f$
- * @param[in] q : lista wielomianów składanych z @f$p@f$
- * @return @f$p(q_0, q_1, \dots)@f$
- */ 
-static Poly PolyProductCompose(const Poly *p, size_t k, const Poly q[]) {
+poly_coeff_t PolyEval(const Poly *p, const poly_coeff_t x[], size_t k) {
     if (PolyIsCoeff(p)) {
-        return PolyClone(p);
+        return p->coeff;
+    }
+    else if (k == 0) {
+        return MonoGetExp(&p->arr[0]) == 0 ? PolyEval(&p->arr[0].p, x, 0) : 0;
+    }
+
+    poly_coeff_t value = 0;
+
+    for (size_t i = p->size; i > 0; i--) {
+        poly_exp_t gap = MonoGetExp(&p->arr[i - 1]) - (i > 1 ? MonoGetExp(&p->arr[i - 2]) : 0);
+
+        value = (value + PolyEval(&p->arr[i - 1].p, x + 1, k - 1)) * CoeffPower(x[0], gap);
     }
 
-    Poly p_clone = PolyClone(p);
-    Poly r = p_clone;
+    return value;
+}
+
+/**
+ * Pamięć podręczna potęg wielomianu. Potęgi są trzymane w tablicy
+ * jednomianów posortowanej rosnąco po wykładnikach, a jednomian
+ * @f$(q^e, e)@f$ oznacza potęgę @f$q^e@f$.
+ */
+typedef struct PowerCache {
+    const Poly *base; ///< podstawa potęg
+    size_t size; ///< liczba zapamiętanych potęg
+    Mono *powers; ///< zapamiętane potęgi
+} PowerCache;
+
+/**
+ * Wyszukuje binarnie miejsce potęgi w pamięci podręcznej.
+ * @param[in] cache : pamięć podręczna potęg
+ * @param[in] exp : wykładnik
+ * @return indeks pierwszej potęgi o wykładniku nie mniejszym niż @p exp
+ */
+static size_t PowerCacheFind(const PowerCache *cache, poly_exp_t exp) {
+    size_t lo = 0;
+    size_t hi = cache->size;
 
-    size_t n = 0;
-    while (!PolyIsCoeff(&r) && r.arr[0].exp == 0) {
-        n++;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
 
-        r = r.arr[0].p;
+        if (MonoGetExp(&cache->powers[mid]) < exp) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
     }
 
-    r = p_clone;
+    return lo;
+}
 
-    for (size_t i = 0; i < n; i++) {
-        r = r.arr[0].p;
+/**
+ * Zwraca potęgę podstawy, wyliczając ją w razie potrzeby przez podnoszenie
+ * do kwadratu. Wyliczone potęgi (także pośrednie kwadraty) są zapamiętywane.
+ * Zwrócony wielomian należy do pamięci podręcznej.
+ * @param[in, out] cache : pamięć podręczna potęg
+ * @param[in] exp : wykładnik (dodatni)
+ * @return @f$q^{exp}@f$
+ */
+static Poly PowerCacheGet(PowerCache *cache, poly_exp_t exp) {
+    if (exp == 1) {
+        return *cache->base;
     }
 
-    poly_exp_t r_exp = r.arr[0].exp;
+    size_t lo = PowerCacheFind(cache, exp);
 
-    r.arr[0].exp = 0;
-    
-    Poly s = PolyFromCoeff(1);
-    for (poly_exp_t i = 0; i < r_exp; i++) {
-        Poly t = PolyMul(&s, &q[n]);
+    if (lo < cache->size && MonoGetExp(&cache->powers[lo]) == exp) {
+        return cache->powers[lo].p;
+    }
+
+    Poly half = PowerCacheGet(cache, exp / 2);
+    Poly r = PolySqr(&half);
+
+    if (exp % 2 == 1) {
+        r = PolyMulOwn(r, PolyClone(cache->base));
+    }
 
-        PolyDestroy(&s);
+    lo = PowerCacheFind(cache, exp);
+
+    cache->powers = MonosReserve(cache->powers, cache->size + 1);
+    memmove(&cache->powers[lo + 1], &cache->powers[lo], (cache->size - lo) * sizeof(Mono));
+    cache->powers[lo] = (Mono) {.p = r, .exp = exp};
+    cache->size++;
+
+    return r;
+}
 
-        s = t;
+/**
+ * Mnoży wielomian przez potęgę z pamięci podręcznej, przejmując go na własność.
+ * @param[in] p : wielomian
+ * @param[in, out] cache : pamięć podręczna potęg
+ * @param[in] exp : wykładnik (dodatni)
+ * @return @f$p \cdot q^{exp}@f$
+ */
+static Poly PolyMulPowerOwn(Poly p, PowerCache *cache, poly_exp_t exp) {
+    if (PolyIsZero(&p)) {
+        return p;
     }
 
-    Poly u;
-    if (r.arr[0].p.arr != NULL) {
-        u = PolyProductCompose(&p_clone, k, q);
+    Poly power = PowerCacheGet(cache, exp);
+
+    if (PolyIsCoeff(&power)) {
+        return PolyMulOwn(p, power);
     }
-    else {
-        u = PolyFromCoeff(r.arr[0].p.coeff);
+    else if (PolyIsCoeff(&p) && p.coeff == 1) {
+        return PolyClone(&power);
     }
 
-    Poly w = PolyMul(&s, &u);
+    Poly r = PolyMul(&p, &power);
 
-    PolyDestroy(&p_clone);
-    PolyDestroy(&s);
-    PolyDestroy(&u);
+    PolyDestroy(&p);
 
-    return w;
+    return r;
 }
 
 /**
- * Zamienia wielomian na listę wielomianów postaci @f$a\cdot\prod_{i=0}^n x_i^{t_i}@f$.
+ * Składa wielomian zmiennych @f$x_{var}, x_{var + 1}, \dots@f$ z wielomianami
+ * @f$q_{var}, q_{var + 1}, \dots, q_{k-1}@f$, a pod pozostałe zmienne
+ * podstawia zero. Dla każdej zmiennej stosuje schemat Hornera: wynik jest
+ * mnożony przez potęgi @f$q_{var}@f$ o wykładnikach równych różnicom
+ * sąsiednich wykładników, a potęgi są brane z pamięci podręcznej.
  * @param[in] p : wielomian
- * @param[out] poly_arr : wskaźnik na tablicę, w której zostaną zapiasane powstałe wielomiany
- * @param[out] number_of_polys : wskaźnik na zmienną, w której zostanie zapiasana liczba powstałych wielomianów
- */ 
-static void PolyAsSum(const Poly *p, Poly **poly_arr, size_t *number_of_polys) {
+ * @param[in] var : numer zmiennej wielomianu @p p
+ * @param[in] k : liczba wielomianów składanych
+ * @param[in, out] caches : pamięci podręczne potęg wielomianów składanych
+ * @return wynik złożenia
+ */
+static Poly PolyComposeAux(const Poly *p, size_t var, size_t k, PowerCache caches[]) {
     if (PolyIsCoeff(p)) {
-        Poly *arr = malloc(sizeof(Poly));
-        CHECK_PTR(arr);
-        arr[0] = PolyClone(p);
-
-        *poly_arr = arr;
-        *number_of_polys = 1;
+        return PolyFromCoeff(p->coeff);
+    }
+    else if (var >= k) {
+        return PolyFromCoeff(PolyEval(p, NULL, 0));
     }
-    else {
-        Poly **arrays = malloc(p->size * sizeof(Poly*));
-        CHECK_PTR(arrays);
-        size_t *numbers = malloc(p->size * sizeof(size_t));
-        CHECK_PTR(numbers);
-        size_t size = 0;
 
-        for (size_t i = 0; i < p->size; i++) {
-            PolyAsSum(&(p->arr[i].p), &(arrays[i]), &(numbers[i]));
+    Poly r = PolyComposeAux(&p->arr[p->size - 1].p, var + 1, k, caches);
 
-            size += numbers[i];
+    // Zerowy wynik pośredni (np. gdy współczynniki zależą tylko od zmiennych,
+    // pod które podstawiamy zero) nie jest mnożony przez potęgi, więc nie
+    // wyliczamy potęg, które i tak nie wpłynęłyby na wynik.
+    for (size_t i = p->size - 1; i > 0; i--) {
+        if (!PolyIsZero(&r)) {
+            r = PolyMulPowerOwn(r, &caches[var], MonoGetExp(&p->arr[i]) - MonoGetExp(&p->arr[i - 1]));
         }
 
-        Poly *arr = malloc(size * sizeof(Poly));
-        CHECK_PTR(arr);
-        size_t count = 0;
+        r = PolyAddOwn(r, PolyComposeAux(&p->arr[i - 1].p, var + 1, k, caches));
+    }
 
-        for (size_t i = 0; i < p->size; i++) {
-            for (size_t j = 0; j < numbers[i]; j++) {
-                Mono m = (Mono) {.exp = p->arr[i].exp, .p = arrays[i][j]};
+    if (MonoGetExp(&p->arr[0]) > 0 && !PolyIsZero(&r)) {
+        r = PolyMulPowerOwn(r, &caches[var], MonoGetExp(&p->arr[0]));
+    }
 
-                Mono* m_arr = malloc(sizeof(Mono));
-                CHECK_PTR(m_arr);
-                m_arr[0] = m;
+    return r;
+}
 
-                arr[count + j] = (Poly) {.size = 1, .arr = m_arr};
-            }
+/**
+ * Składa wielomian niebędący współczynnikiem z @p k > 0 wielomianami,
+ * bez użycia pamięci podręcznej wyników.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba wielomianów składanych
+ * @param[in] q : wielomiany składane
+ * @return wynik złożenia
+ */
+static Poly PolyComposeCompute(const Poly *p, size_t k, const Poly q[]) {
+    ArenaMark mark = ArenaGetMark(&scratch_arena);
+    PowerCache *caches = ArenaAlloc(&scratch_arena, k * sizeof(PowerCache));
 
-            count += numbers[i];
-        }
+    for (size_t i = 0; i < k; i++) {
+        caches[i] = (PowerCache) {.base = &q[i], .size = 0, .powers = NULL};
+    }
 
-        Poly r = arr[0];
-        bool isCoeff = true;
-        while (r.arr != NULL) {
-            if (r.arr[0].exp != 0) {
-                isCoeff = false;
-            }
+    Poly r = PolyComposeAux(p, 0, k, caches);
 
-            r = r.arr[0].p;
+    for (size_t i = 0; i < k; i++) {
+        for (size_t j = 0; j < caches[i].size; j++) {
+            MonoDestroy(&caches[i].powers[j]);
         }
 
-        if (isCoeff) {
-            PolyDestroy(&arr[0]);
-            arr[0] = PolyFromCoeff(r.coeff);
-        }
+        MonosFree(caches[i].powers);
+    }
+    ArenaRelease(&scratch_arena, mark);
 
-        *poly_arr = arr;
-        *number_of_polys = count;
+    return r;
+}
 
-        for (size_t i = 0; i < p->size; i++) {
-            free(arrays[i]);
+Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
+    if (PolyIsCoeff(p) || k == 0) {
+        return PolyFromCoeff(PolyEval(p, NULL, 0));
+    }
+    else if (cached_calls > 0) {
+        return PolyComposeCompute(p, k, q);
+    }
+
+    Poly r;
+
+    if (PolyCacheLookup(POLY_CACHE_COMPOSE, p, k, q, 0, &r)) {
+        return r;
+    }
+
+    cached_calls++;
+    r = PolyComposeCompute(p, k, q);
+    cached_calls--;
+
+    PolyCacheStore(POLY_CACHE_COMPOSE, p, k, q, 0, &r);
+
+    return r;
+}
+
+/**
+ * Sprawdza, czy wielomian jest równy wielomianowi internowanemu. Zakładamy,
+ * że współczynniki @p p są internowane, więc współczynniki wielomianowe
+ * wystarczy porównać po adresach tablic.
+ * @param[in] p : wielomian
+ * @param[in] interned : wielomian internowany
+ * @return czy wielomiany są równe?
+ */
+static bool InternMatch(const Poly *p, const Poly *interned) {
+    if (p->size != interned->size || PolyGetMeta(p)->hash != MonosMeta(interned->arr)->hash) {
+        return false;
+    }
+
+    for (size_t i = 0; i < p->size; i++) {
+        const Mono *a = &p->arr[i];
+        const Mono *b = &interned->arr[i];
+
+        if (a->exp != b->exp || a->p.arr != b->p.arr || (PolyIsCoeff(&a->p) && a->p.coeff != b->p.coeff)) {
+            return false;
         }
-        free(arrays);
-        free(numbers);
     }
+
+    return true;
 }
 
-Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
-    Poly p_clone = PolyClone(p);
+/**
+ * Wstawia wielomian do tablicy wielomianów internowanych, w razie potrzeby
+ * ją powiększając (tablica jest zapełniona co najwyżej w połowie).
+ * @param[in] p : wielomian z aktualnymi metadanymi, którego nie ma w tablicy
+ */
+static void InternInsert(const Poly *p) {
+    if (2 * (intern_table.size + 1) > intern_table.capacity) {
+        InternTable old = intern_table;
+
+        intern_table.capacity = old.capacity == 0 ? INTERN_INITIAL_CAPACITY : 2 * old.capacity;
+        intern_table.slots = calloc(intern_table.capacity, sizeof(Poly));
+        CHECK_PTR(intern_table.slots);
+
+        for (size_t i = 0; i < old.capacity; i++) {
+            if (old.slots[i].arr != NULL) {
+                size_t j = InternSlot(MonosMeta(old.slots[i].arr)->hash);
+                while (intern_table.slots[j].arr != NULL) {
+                    j = (j + 1) & (intern_table.capacity - 1);
+                }
+
+                intern_table.slots[j] = old.slots[i];
+            }
+        }
 
-    PolyTrim(&p_clone, k);
+        free(old.slots);
+    }
 
-    if (k == 0) {
-        return p_clone;
+    size_t i = InternSlot(MonosMeta(p->arr)->hash);
+    while (intern_table.slots[i].arr != NULL) {
+        i = (i + 1) & (intern_table.capacity - 1);
     }
-    else {
-        Poly *poly_arr = NULL;
-        size_t number_of_polys = 0;
 
-        PolyAsSum(&p_clone, &poly_arr, &number_of_polys);
+    intern_table.slots[i] = *p;
+    intern_table.size++;
+    MonosMeta(p->arr)->interned = true;
+}
 
-        Poly r = PolyZero();
-        
-        for (size_t i = 0; i < number_of_polys; i++) {
-            Poly s = PolyProductCompose(&(poly_arr[i]), k, q);
+Poly PolyInternOwn(Poly p) {
+    if (PolyIsCoeff(&p) || MonosMeta(p.arr)->interned) {
+        return p;
+    }
 
-            Poly t = PolyAdd(&s, &r);
+    // Zastąpienie współczynników równymi im wielomianami nie zmienia metadanych.
+    PolyUnshare(&p);
 
-            PolyDestroy(&r);
-            PolyDestroy(&s);
-            PolyDestroy(&(poly_arr[i]));
+    for (size_t i = 0; i < p.size; i++) {
+        p.arr[i].p = PolyInternOwn(p.arr[i].p);
+    }
 
-            r = t;
-        }
+    if (intern_table.capacity > 0) {
+        size_t mask = intern_table.capacity - 1;
 
-        PolyDestroy(&p_clone);
-        free(poly_arr);
+        for (size_t i = InternSlot(PolyGetMeta(&p)->hash); intern_table.slots[i].arr != NULL; i = (i + 1) & mask) {
+            if (InternMatch(&p, &intern_table.slots[i])) {
+                Poly r = PolyClone(&intern_table.slots[i]);
 
-        return r;
+                PolyDestroy(&p);
+
+                return r;
+            }
+        }
     }
-}
\ No newline at end of file
+
+    PolyGetMeta(&p);
+    InternInsert(&p);
+
+    return p;
+}
@@ -1,6 +1,14 @@
 /** @file
   Interfejs klasy wielomianów rzadkich wielu zmiennych
 
+  Wszystkie struktury pomocnicze biblioteki: pula pamięci na tablice
+  jednomianów (zob. poly_pool.h), arena tablic tymczasowych, tablica
+  wielomianów internowanych i pamięć podręczna wyników (zob. poly_cache.h)
+  są osobne dla każdego wątku. Wielomian, wraz ze wszystkimi jego kopiami
+  (kopie współdzielą pamięć, a liczniki odwołań nie są atomowe), może być
+  używany i usuwany tylko w wątku, który go utworzył. Różne wątki mogą
+  jednocześnie wykonywać operacje na własnych wielomianach.
+
   @authors Jakub Pawlewicz <pan@mimuw.edu.pl>, Marcin Peczarski <marpe@mimuw.edu.pl>
   @copyright Uniwersytet Warszawski
   @date 2021
@@ -12,6 +20,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /** To jest typ reprezentujący współczynniki. */
 typedef long poly_coeff_t;
@@ -125,14 +134,17 @@ static inline void MonoDestroy(Mono *m) {
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu w czasie stałym. Kopia współdzieli pamięć
+ * z oryginałem, która jest kopiowana dopiero wtedy, gdy jeden z nich
+ * jest modyfikowany w miejscu, więc kopia zachowuje się jak pełna,
+ * głęboka kopia.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Robi kopię jednomianu (tak jak PolyClone).
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
@@ -148,6 +160,26 @@ static inline Mono MonoClone(const Mono *m) {
  */
 Poly PolyAdd(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje dwa wielomiany, przejmując je na własność.
+ * Wynik powstaje w pamięci argumentów, bez kopiowania jednomianów.
+ * Po wywołaniu @p p i @p q nie mogą być już używane.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyAddOwn(Poly p, Poly q);
+
+/**
+ * Dodaje wielomian do akumulatora w miejscu: @f$acc := acc + p@f$.
+ * Tablica jednomianów akumulatora jest powiększana z zamortyzowanym kosztem,
+ * a kopiowane są tylko te jednomiany @p p, których wykładników nie ma
+ * w akumulatorze. Wielomian @p p nie może być częścią akumulatora.
+ * @param[in, out] acc : akumulator
+ * @param[in] p : wielomian @f$p@f$
+ */
+void PolyAddTo(Poly *acc, const Poly *p);
+
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
@@ -188,6 +220,43 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Mnoży dwa wielomiany, przejmując je na własność.
+ * Mnożenie przez współczynnik odbywa się w miejscu.
+ * Po wywołaniu @p p i @p q nie mogą być już używane.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMulOwn(Poly p, Poly q);
+
+/**
+ * Podnosi wielomian do kwadratu. Liczy tylko iloczyny jednomianów
+ * @f$p_i p_j@f$ dla @f$i \leq j@f$ i podwaja sumy iloczynów różnych
+ * jednomianów, więc wykonuje około połowy mnożeń funkcji PolyMul.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p^2@f$
+ */
+Poly PolySqr(const Poly *p);
+
+/**
+ * Podnosi wielomian do potęgi metodą „podnieś do kwadratu i pomnóż”,
+ * czyli wykonuje @f$O(\log e)@f$ mnożeń.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] e : wykładnik @f$e \geq 0@f$
+ * @return @f$p^e@f$
+ */
+Poly PolyPow(const Poly *p, poly_exp_t e);
+
+/**
+ * Dodaje iloczyn dwóch wielomianów do akumulatora w miejscu:
+ * @f$acc := acc + p * q@f$.
+ * @param[in, out] acc : akumulator
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ */
+void PolyFma(Poly *acc, const Poly *p, const Poly *q);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -195,6 +264,14 @@ Poly PolyMul(const Poly *p, const Poly *q);
  */
 Poly PolyNeg(const Poly *p);
 
+/**
+ * Zwraca przeciwny wielomian, przejmując @p p na własność i negując go
+ * w miejscu. Po wywołaniu @p p nie może być już używany.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNegOwn(Poly p);
+
 /**
  * Odejmuje wielomian od wielomianu.
  * @param[in] p : wielomian @f$p@f$
@@ -203,6 +280,15 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Odejmuje wielomian od wielomianu, przejmując oba na własność.
+ * Po wywołaniu @p p i @p q nie mogą być już używane.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwn(Poly p, Poly q);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
@@ -222,6 +308,41 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx);
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zwraca liczbę niezerowych współczynników liczbowych wielomianu,
+ * czyli liczbę jednomianów po rozwinięciu go do postaci sumy jednomianów
+ * wielu zmiennych.
+ * @param[in] p : wielomian
+ * @return liczba współczynników
+ */
+size_t PolyTerms(const Poly *p);
+
+/**
+ * Zwraca głębokość wielomianu: zero dla współczynnika, jeden dla wielomianu,
+ * którego wszystkie współczynniki są liczbami, i o jeden więcej niż
+ * największa głębokość współczynnika w pozostałych przypadkach.
+ * @param[in] p : wielomian
+ * @return głębokość
+ */
+size_t PolyDepth(const Poly *p);
+
+/**
+ * Zwraca rozmiar pamięci zajmowanej przez tablice jednomianów wielomianu
+ * i wszystkich jego współczynników, wraz z nagłówkami i zaokrągleniem do
+ * klas puli pamięci. Tablice współdzielone są liczone przy każdym
+ * wystąpieniu, więc wynik jest oszacowaniem z góry.
+ * @param[in] p : wielomian
+ * @return rozmiar w bajtach
+ */
+size_t PolyMemory(const Poly *p);
+
+/**
+ * Wylicza skrót wielomianu. Równe wielomiany mają równe skróty.
+ * @param[in] p : wielomian
+ * @return skrót
+ */
+uint64_t PolyHash(const Poly *p);
+
 /**
  * Sprawdza równość dwóch wielomianów.
  * @param[in] p : wielomian @f$p@f$
@@ -230,6 +351,18 @@ poly_exp_t PolyDeg(const Poly *p);
  */
 bool PolyIsEq(const Poly *p, const Poly *q);
 
+/**
+ * Internuje wielomian: zwraca równy mu wielomian, którego wszystkie
+ * poddrzewa są współdzielone z równymi im poddrzewami innych wielomianów
+ * internowanych. Równe wielomiany internowane mają więc tę samą pamięć,
+ * a PolyIsEq porównuje je po adresach. Wielomiany internowane można dalej
+ * używać jak zwykłych; zmieniany jest wtedy ich prywatny egzemplarz.
+ * Przejmuje na własność wielomian @p p.
+ * @param[in] p : wielomian
+ * @return wielomian równy @p p
+ */
+Poly PolyInternOwn(Poly p);
+
 /**
  * Wylicza wartość wielomianu w punkcie @p x.
  * Wstawia pod pierwszą zmienną wielomianu wartość @p x.
@@ -243,6 +376,31 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartości wielomianu w wielu punktach.
+ * Dla każdego @f$j < n@f$ zapisuje w @p out[j] wynik PolyAt(p, xs[j]).
+ * Gdy współczynniki wielomianu są liczbami, tablica jednomianów jest
+ * przechodzona raz, a wartości we wszystkich punktach są liczone razem.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] xs : punkty @f$x_0, x_1, \ldots, x_{n-1}@f$
+ * @param[in] n : liczba punktów
+ * @param[out] out : tablica na @p n wyników
+ */
+void PolyAtMany(const Poly *p, const poly_coeff_t xs[], size_t n, Poly out[]);
+
+/**
+ * Wylicza wartość liczbową wielomianu w punkcie @f$(x_0, \ldots, x_{k-1})@f$.
+ * Pod zmienne o indeksach większych lub równych @p k podstawia zero.
+ * Formalnie dla wielomianu @f$p(x_0, x_1, x_2, \ldots)@f$ wynikiem jest
+ * @f$p(x_0, \ldots, x_{k-1}, 0, 0, \ldots)@f$.
+ * Nie alokuje pamięci.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : tablica wartości zmiennych
+ * @param[in] k : liczba wartości w tablicy @p x
+ * @return @f$p(x_0, \ldots, x_{k-1}, 0, 0, \ldots)@f$
+ */
+poly_coeff_t PolyEval(const Poly *p, const poly_coeff_t x[], size_t k);
+
 /**
  * Składa wielomian @f$p@f$ z wielomianami @f$q_0, q_1, \dots, q_{k-1}@f$.
  * @param[in] p : wielomian @f$p@f$
@@ -252,4 +410,11 @@ Poly PolyAt(const Poly *p, poly_coeff_t x);
  */ 
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]);
 
+/**
+ * Oddaje systemowi pamięć pomocniczą operacji na wielomianach bieżącego
+ * wątku (arenę na tablice tymczasowe). Nie może być wywołana w trakcie
+ * operacji na wielomianach.
+ */
+void PolyScratchFree(void);
+
 #endif /* __POLY_H__ */
@@ -0,0 +1,298 @@
+/** @file
+  Implementacja pamięci podręcznej wyników kosztownych operacji na wielomianach
+
+  Wyniki są trzymane w tablicy haszującej z listami łańcuchowymi, a wszystkie
+  wpisy tworzą też dwukierunkową listę uporządkowaną od ostatnio do najdawniej
+  używanego. Rozmiar wpisu to rozmiar samego wpisu i tablicy jego argumentów
+  oraz pamięć zajmowana przez argumenty i wynik według funkcji PolyMemory.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "poly_cache.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Początkowa liczba list w tablicy haszującej.
+ */
+#define INITIAL_BUCKETS 64
+
+/**
+ * Zapamiętany wynik operacji.
+ */
+typedef struct CacheEntry {
+    uint64_t hash; ///< skrót klucza
+    PolyCacheOp op; ///< operacja
+    poly_exp_t exp; ///< wykładnik
+    size_t k; ///< liczba pozostałych argumentów
+    Poly *args; ///< kopie wszystkich @p k + 1 argumentów
+    Poly result; ///< kopia wyniku
+    size_t bytes; ///< szacowany rozmiar wpisu
+    struct CacheEntry *newer; ///< poprzedni wpis na liście LRU
+    struct CacheEntry *older; ///< następny wpis na liście LRU
+    struct CacheEntry *chain; ///< następny wpis na liście w tablicy haszującej
+} CacheEntry;
+
+/**
+ * Pamięć podręczna.
+ */
+typedef struct PolyCache {
+    size_t buckets_count; ///< liczba list (zero albo potęga dwójki)
+    CacheEntry **buckets; ///< listy wpisów o tych samych końcówkach skrótów
+    CacheEntry *newest; ///< ostatnio używany wpis
+    CacheEntry *oldest; ///< najdawniej używany wpis
+    PolyCacheStats stats; ///< statystyki
+} PolyCache;
+
+/**
+ * Pamięć podręczna wyników bieżącego wątku.
+ */
+static _Thread_local PolyCache cache = {
+    .buckets_count = 0, .buckets = NULL, .newest = NULL, .oldest = NULL,
+    .stats = {.hits = 0, .misses = 0, .evictions = 0, .entries = 0, .bytes = 0, .limit = 0}
+};
+
+/**
+ * Wylicza skrót klucza operacji.
+ * @param[in] op : operacja
+ * @param[in] p : pierwszy argument
+ * @param[in] k : liczba pozostałych argumentów
+ * @param[in] q : pozostałe argumenty
+ * @param[in] exp : wykładnik
+ * @return skrót
+ */
+static uint64_t KeyHash(PolyCacheOp op, const Poly *p, size_t k, const Poly q[], poly_exp_t exp) {
+    uint64_t hash = ((uint64_t)op << 32) ^ (uint32_t)exp;
+
+    hash = (hash ^ PolyHash(p)) * 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < k; i++) {
+        hash = (hash ^ PolyHash(&q[i])) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Sprawdza, czy wpis jest wynikiem danej operacji.
+ * @param[in] entry : wpis
+ * @param[in] hash : skrót klucza
+ * @param[in] op : operacja
+ * @param[in] p : pierwszy argument
+ * @param[in] k : liczba pozostałych argumentów
+ * @param[in] q : pozostałe argumenty
+ * @param[in] exp : wykładnik
+ * @return czy klucze są równe?
+ */
+static bool EntryMatches(const CacheEntry *entry, uint64_t hash, PolyCacheOp op, const Poly *p, size_t k,
+                         const Poly q[], poly_exp_t exp) {
+    if (entry->hash != hash || entry->op != op || entry->exp != exp || entry->k != k
+        || !PolyIsEq(&entry->args[0], p)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < k; i++) {
+        if (!PolyIsEq(&entry->args[i + 1], &q[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Odłącza wpis od listy LRU.
+ * @param[in, out] entry : wpis
+ */
+static void LruUnlink(CacheEntry *entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    }
+    else {
+        cache.newest = entry->older;
+    }
+
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    }
+    else {
+        cache.oldest = entry->newer;
+    }
+}
+
+/**
+ * Wstawia wpis na początek listy LRU.
+ * @param[in, out] entry : wpis
+ */
+static void LruPushFront(CacheEntry *entry) {
+    entry->newer = NULL;
+    entry->older = cache.newest;
+
+    if (cache.newest != NULL) {
+        cache.newest->newer = entry;
+    }
+    else {
+        cache.oldest = entry;
+    }
+
+    cache.newest = entry;
+}
+
+/**
+ * Usuwa wpis z pamięci podręcznej i zwalnia go.
+ * @param[in] entry : wpis
+ */
+static void EntryRemove(CacheEntry *entry) {
+    CacheEntry **link = &cache.buckets[entry->hash & (cache.buckets_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+
+    LruUnlink(entry);
+
+    cache.stats.entries--;
+    cache.stats.bytes -= entry->bytes;
+
+    for (size_t i = 0; i <= entry->k; i++) {
+        PolyDestroy(&entry->args[i]);
+    }
+    PolyDestroy(&entry->result);
+    free(entry->args);
+    free(entry);
+}
+
+/**
+ * Usuwa najdawniej używane wpisy, dopóki rozmiar przekracza limit.
+ */
+static void EvictOverLimit(void) {
+    while (cache.stats.bytes > cache.stats.limit) {
+        EntryRemove(cache.oldest);
+        cache.stats.evictions++;
+    }
+}
+
+/**
+ * Podwaja liczbę list w tablicy haszującej.
+ */
+static void Rehash(void) {
+    size_t count = cache.buckets_count == 0 ? INITIAL_BUCKETS : 2 * cache.buckets_count;
+    CacheEntry **buckets = calloc(count, sizeof(CacheEntry *));
+    CHECK_PTR(buckets);
+
+    for (size_t i = 0; i < cache.buckets_count; i++) {
+        CacheEntry *entry = cache.buckets[i];
+
+        while (entry != NULL) {
+            CacheEntry *chain = entry->chain;
+
+            entry->chain = buckets[entry->hash & (count - 1)];
+            buckets[entry->hash & (count - 1)] = entry;
+            entry = chain;
+        }
+    }
+
+    free(cache.buckets);
+    cache.buckets = buckets;
+    cache.buckets_count = count;
+}
+
+void PolyCacheSetLimit(size_t bytes) {
+    cache.stats.limit = bytes;
+
+    EvictOverLimit();
+}
+
+PolyCacheStats PolyCacheGetStats(void) {
+    return cache.stats;
+}
+
+void PolyCacheClear(void) {
+    while (cache.oldest != NULL) {
+        EntryRemove(cache.oldest);
+    }
+
+    free(cache.buckets);
+    cache.buckets = NULL;
+    cache.buckets_count = 0;
+    cache.stats.hits = 0;
+    cache.stats.misses = 0;
+    cache.stats.evictions = 0;
+}
+
+bool PolyCacheLookup(PolyCacheOp op, const Poly *p, size_t k, const Poly q[], poly_exp_t exp, Poly *result) {
+    if (cache.stats.limit == 0) {
+        return false;
+    }
+
+    if (cache.buckets_count > 0) {
+        uint64_t hash = KeyHash(op, p, k, q, exp);
+
+        for (CacheEntry *entry = cache.buckets[hash & (cache.buckets_count - 1)]; entry != NULL;
+             entry = entry->chain) {
+            if (EntryMatches(entry, hash, op, p, k, q, exp)) {
+                LruUnlink(entry);
+                LruPushFront(entry);
+                cache.stats.hits++;
+
+                *result = PolyClone(&entry->result);
+
+                return true;
+            }
+        }
+    }
+
+    cache.stats.misses++;
+
+    return false;
+}
+
+void PolyCacheStore(PolyCacheOp op, const Poly *p, size_t k, const Poly q[], poly_exp_t exp, const Poly *result) {
+    if (cache.stats.limit == 0) {
+        return;
+    }
+
+    // Wpis obciążamy całą pamięcią tablic jednomianów argumentów i wyniku
+    // (zob. PolyMemory), także gdy współdzieli ją z wielomianami użytkownika.
+    size_t bytes = sizeof(CacheEntry) + (k + 1) * sizeof(Poly) + PolyMemory(p) + PolyMemory(result);
+    for (size_t i = 0; i < k; i++) {
+        bytes += PolyMemory(&q[i]);
+    }
+
+    if (bytes > cache.stats.limit) {
+        return;
+    }
+
+    CacheEntry *entry = malloc(sizeof(CacheEntry));
+    CHECK_PTR(entry);
+    entry->args = malloc((k + 1) * sizeof(Poly));
+    CHECK_PTR(entry->args);
+
+    entry->hash = KeyHash(op, p, k, q, exp);
+    entry->op = op;
+    entry->exp = exp;
+    entry->k = k;
+    entry->args[0] = PolyClone(p);
+    for (size_t i = 0; i < k; i++) {
+        entry->args[i + 1] = PolyClone(&q[i]);
+    }
+    entry->result = PolyClone(result);
+    entry->bytes = bytes;
+
+    if (cache.stats.entries + 1 > cache.buckets_count) {
+        Rehash();
+    }
+
+    size_t bucket = entry->hash & (cache.buckets_count - 1);
+    entry->chain = cache.buckets[bucket];
+    cache.buckets[bucket] = entry;
+    LruPushFront(entry);
+
+    cache.stats.entries++;
+    cache.stats.bytes += bytes;
+
+    EvictOverLimit();
+}
@@ -0,0 +1,84 @@
+/** @file
+  Interfejs pamięci podręcznej wyników kosztownych operacji na wielomianach
+
+  Pamięć podręczna zapamiętuje wyniki funkcji PolyMul (i PolySqr), PolyPow
+  oraz PolyCompose wywołanych spoza biblioteki. Kluczem są skróty argumentów,
+  a przy trafieniu argumenty są porównywane funkcją PolyIsEq. Argumenty
+  i wyniki są przechowywane jako kopie (zob. PolyClone), więc zwykle
+  współdzielą pamięć z wielomianami użytkownika. Gdy szacowany rozmiar
+  zapamiętanych wielomianów przekroczy limit, usuwane są najdawniej używane
+  wyniki. Domyślnie limit jest zerowy, czyli pamięć podręczna jest wyłączona.
+  Każdy wątek ma własną pamięć podręczną z własnym limitem (zob. poly.h).
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __POLY_CACHE_H__
+#define __POLY_CACHE_H__
+
+#include "poly.h"
+
+/**
+ * Operacje, których wyniki są zapamiętywane.
+ */
+typedef enum PolyCacheOp {
+    POLY_CACHE_MUL, ///< iloczyn @f$p \cdot q_0@f$
+    POLY_CACHE_POW, ///< potęga @f$p^{exp}@f$
+    POLY_CACHE_COMPOSE ///< złożenie @f$p(q_0, \dots, q_{k-1})@f$
+} PolyCacheOp;
+
+/**
+ * Statystyki pamięci podręcznej.
+ */
+typedef struct PolyCacheStats {
+    size_t hits; ///< liczba trafień
+    size_t misses; ///< liczba chybień
+    size_t evictions; ///< liczba wyników usuniętych z powodu limitu
+    size_t entries; ///< liczba zapamiętanych wyników
+    size_t bytes; ///< szacowany rozmiar zapamiętanych wielomianów w bajtach
+    size_t limit; ///< limit rozmiaru w bajtach
+} PolyCacheStats;
+
+/**
+ * Ustawia limit rozmiaru pamięci podręcznej i usuwa wyniki, które się w nim
+ * nie mieszczą. Limit zerowy wyłącza pamięć podręczną.
+ * @param[in] bytes : limit w bajtach
+ */
+void PolyCacheSetLimit(size_t bytes);
+
+/**
+ * Zwraca statystyki pamięci podręcznej.
+ * @return statystyki
+ */
+PolyCacheStats PolyCacheGetStats(void);
+
+/**
+ * Usuwa wszystkie zapamiętane wyniki i zeruje liczniki. Nie zmienia limitu.
+ */
+void PolyCacheClear(void);
+
+/**
+ * Wyszukuje zapamiętany wynik operacji.
+ * @param[in] op : operacja
+ * @param[in] p : pierwszy argument
+ * @param[in] k : liczba pozostałych argumentów
+ * @param[in] q : pozostałe argumenty
+ * @param[in] exp : wykładnik (dla POLY_CACHE_POW, w pozostałych przypadkach 0)
+ * @param[out] result : kopia wyniku, jeżeli został znaleziony
+ * @return czy wynik został znaleziony?
+ */
+bool PolyCacheLookup(PolyCacheOp op, const Poly *p, size_t k, const Poly q[], poly_exp_t exp, Poly *result);
+
+/**
+ * Zapamiętuje wynik operacji, której wyniku nie ma w pamięci podręcznej.
+ * @param[in] op : operacja
+ * @param[in] p : pierwszy argument
+ * @param[in] k : liczba pozostałych argumentów
+ * @param[in] q : pozostałe argumenty
+ * @param[in] exp : wykładnik (dla POLY_CACHE_POW, w pozostałych przypadkach 0)
+ * @param[in] result : wynik
+ */
+void PolyCacheStore(PolyCacheOp op, const Poly *p, size_t k, const Poly q[], poly_exp_t exp, const Poly *result);
+
+#endif /* __POLY_CACHE_H__ */
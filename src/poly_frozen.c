@@ -0,0 +1,403 @@
+/** @file
+  Implementacja wielomianów zamrożonych
+
+  Blok składa się z tablic jednomianów, za nimi współczynników liści, a na
+  końcu wykładników liści. Blok jest zerowany przy przydziale, więc bajty
+  wyrównania w jednomianach mają zawsze tę samą wartość, a ułożenie bloku
+  zależy tylko od wielomianu. Dzięki temu równe wielomiany mają identyczne
+  bloki.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "poly_frozen.h"
+#include "poly_math.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Zwraca tablicę współczynników liści.
+ * @param[in] p : wielomian zamrożony
+ * @return współczynniki liści
+ */
+static inline poly_coeff_t *FrozenLeafCoeffs(const PolyFrozen *p) {
+    return (poly_coeff_t *)(p->block + p->count);
+}
+
+/**
+ * Zwraca tablicę wykładników liści.
+ * @param[in] p : wielomian zamrożony
+ * @return wykładniki liści
+ */
+static inline poly_exp_t *FrozenLeafExps(const PolyFrozen *p) {
+    return (poly_exp_t *)(FrozenLeafCoeffs(p) + p->leaves);
+}
+
+/**
+ * Zwraca rozmiar bloku w bajtach.
+ * @param[in] p : wielomian zamrożony
+ * @return rozmiar bloku
+ */
+static inline size_t FrozenBytes(const PolyFrozen *p) {
+    return p->count * sizeof(FrozenMono) + p->leaves * (sizeof(poly_coeff_t) + sizeof(poly_exp_t));
+}
+
+/**
+ * Sprawdza, czy wszystkie współczynniki wielomianu są liczbami. Głębokość
+ * jest zapamiętana w metadanych wielomianu, więc współczynniki nie są
+ * przeglądane ani w FreezeCount, ani ponownie w FreezeAux.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return czy @p p jest liściem?
+ */
+static inline bool IsLeaf(const Poly *p) {
+    return PolyDepth(p) == 1;
+}
+
+/**
+ * Zlicza jednomiany drzewa wielomianu (współdzielone poddrzewa wielokrotnie),
+ * osobno jednomiany liści i pozostałe.
+ * @param[in] p : wielomian
+ * @param[in, out] f : wielomian zamrożony, w którym są zliczane jednomiany
+ */
+static void FreezeCount(const Poly *p, PolyFrozen *f) {
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    else if (IsLeaf(p)) {
+        f->leaves += p->size;
+
+        return;
+    }
+
+    f->count += p->size;
+    for (size_t i = 0; i < p->size; i++) {
+        FreezeCount(&p->arr[i].p, f);
+    }
+}
+
+/**
+ * Zapisuje liść w tablicach liści od pozycji @p offset.
+ * @param[in] p : liść
+ * @param[in, out] f : wielomian zamrożony
+ * @param[in] offset : pozycja pierwszego jednomianu liścia
+ */
+static void FreezeLeaf(const Poly *p, PolyFrozen *f, size_t offset) {
+    poly_coeff_t *coeffs = FrozenLeafCoeffs(f) + offset;
+    poly_exp_t *exps = FrozenLeafExps(f) + offset;
+
+    for (size_t i = 0; i < p->size; i++) {
+        coeffs[i] = p->arr[i].p.coeff;
+        exps[i] = MonoGetExp(&p->arr[i]);
+    }
+}
+
+/**
+ * Zapisuje jednomiany wielomianu w bloku od pozycji @p offset, a tablice ich
+ * współczynników za już zajętą częścią bloku albo tablic liści.
+ * @param[in] p : wielomian niebędący współczynnikiem ani liściem
+ * @param[in, out] f : wielomian zamrożony
+ * @param[in] offset : pozycja tablicy jednomianów @p p
+ * @param[in, out] next : pierwsza wolna pozycja bloku
+ * @param[in, out] next_leaf : pierwsza wolna pozycja tablic liści
+ */
+static void FreezeAux(const Poly *p, PolyFrozen *f, size_t offset, size_t *next, size_t *next_leaf) {
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *c = &p->arr[i].p;
+        FrozenMono *m = &f->block[offset + i];
+
+        m->exp = MonoGetExp(&p->arr[i]);
+
+        if (PolyIsCoeff(c)) {
+            m->p.size = 0;
+            m->p.coeff = c->coeff;
+        }
+        else if (IsLeaf(c)) {
+            m->leaf = true;
+            m->p.size = c->size;
+            m->p.offset = *next_leaf;
+            *next_leaf += c->size;
+
+            FreezeLeaf(c, f, m->p.offset);
+        }
+        else {
+            m->p.size = c->size;
+            m->p.offset = *next;
+            *next += c->size;
+
+            FreezeAux(c, f, m->p.offset, next, next_leaf);
+        }
+    }
+}
+
+PolyFrozen PolyFreeze(const Poly *p) {
+    PolyFrozen f = {.root = {.size = 0, .coeff = p->coeff}, .leaf = false, .count = 0, .leaves = 0, .block = NULL};
+
+    if (PolyIsCoeff(p)) {
+        return f;
+    }
+
+    FreezeCount(p, &f);
+
+    f.root = (FrozenRef) {.size = p->size, .offset = 0};
+    f.block = calloc(1, FrozenBytes(&f));
+    CHECK_PTR(f.block);
+
+    if (IsLeaf(p)) {
+        f.leaf = true;
+
+        FreezeLeaf(p, &f, 0);
+    }
+    else {
+        size_t next = p->size;
+        size_t next_leaf = 0;
+
+        FreezeAux(p, &f, 0, &next, &next_leaf);
+    }
+
+    return f;
+}
+
+/**
+ * Odtwarza wielomian z fragmentu bloku, mnożąc jego współczynniki przez liczbę.
+ * @param[in] f : wielomian zamrożony
+ * @param[in] ref : współczynnik w bloku
+ * @param[in] leaf : czy @p ref jest liściem?
+ * @param[in] factor : mnożnik
+ * @return wielomian równy @p ref pomnożonemu przez @p factor
+ */
+static Poly ThawScaled(const PolyFrozen *f, FrozenRef ref, bool leaf, poly_coeff_t factor) {
+    if (ref.size == 0) {
+        return PolyFromCoeff(ref.coeff * factor);
+    }
+
+    Mono *monos = malloc(ref.size * sizeof(Mono));
+    CHECK_PTR(monos);
+
+    if (leaf) {
+        const poly_coeff_t *coeffs = FrozenLeafCoeffs(f) + ref.offset;
+        const poly_exp_t *exps = FrozenLeafExps(f) + ref.offset;
+
+        for (size_t i = 0; i < ref.size; i++) {
+            monos[i] = (Mono) {.p = PolyFromCoeff(coeffs[i] * factor), .exp = exps[i]};
+        }
+    }
+    else {
+        for (size_t i = 0; i < ref.size; i++) {
+            const FrozenMono *m = &f->block[ref.offset + i];
+
+            monos[i] = (Mono) {.p = ThawScaled(f, m->p, m->leaf, factor), .exp = m->exp};
+        }
+    }
+
+    return PolyOwnMonos(ref.size, monos);
+}
+
+Poly PolyThaw(const PolyFrozen *p) {
+    return ThawScaled(p, p->root, p->leaf, 1);
+}
+
+PolyFrozen PolyFrozenClone(const PolyFrozen *p) {
+    PolyFrozen q = *p;
+
+    if (p->block != NULL) {
+        q.block = malloc(FrozenBytes(p));
+        CHECK_PTR(q.block);
+
+        memcpy(q.block, p->block, FrozenBytes(p));
+    }
+
+    return q;
+}
+
+void PolyFrozenDestroy(PolyFrozen *p) {
+    free(p->block);
+}
+
+/**
+ * Wylicza stopień fragmentu bloku.
+ * @param[in] f : wielomian zamrożony
+ * @param[in] ref : współczynnik w bloku niebędący zerem
+ * @param[in] leaf : czy @p ref jest liściem?
+ * @return stopień @p ref
+ */
+static poly_exp_t FrozenDeg(const PolyFrozen *f, FrozenRef ref, bool leaf) {
+    if (ref.size == 0) {
+        return 0;
+    }
+    else if (leaf) {
+        return FrozenLeafExps(f)[ref.offset + ref.size - 1];
+    }
+
+    poly_exp_t deg = 0;
+    for (size_t i = 0; i < ref.size; i++) {
+        const FrozenMono *m = &f->block[ref.offset + i];
+
+        deg = MAX(deg, m->exp + FrozenDeg(f, m->p, m->leaf));
+    }
+
+    return deg;
+}
+
+poly_exp_t PolyFrozenDeg(const PolyFrozen *p) {
+    if (p->root.size == 0 && p->root.coeff == 0) {
+        return -1;
+    }
+
+    return FrozenDeg(p, p->root, p->leaf);
+}
+
+/**
+ * Wylicza stopień fragmentu bloku ze względu na zmienną.
+ * @param[in] f : wielomian zamrożony
+ * @param[in] ref : współczynnik w bloku niebędący zerem
+ * @param[in] leaf : czy @p ref jest liściem?
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień @p ref ze względu na zmienną @p var_idx
+ */
+static poly_exp_t FrozenDegBy(const PolyFrozen *f, FrozenRef ref, bool leaf, size_t var_idx) {
+    if (ref.size == 0) {
+        return 0;
+    }
+    else if (var_idx == 0) {
+        return leaf ? FrozenLeafExps(f)[ref.offset + ref.size - 1] : f->block[ref.offset + ref.size - 1].exp;
+    }
+    else if (leaf) {
+        return 0;
+    }
+
+    poly_exp_t deg = 0;
+    for (size_t i = 0; i < ref.size; i++) {
+        const FrozenMono *m = &f->block[ref.offset + i];
+
+        deg = MAX(deg, FrozenDegBy(f, m->p, m->leaf, var_idx - 1));
+    }
+
+    return deg;
+}
+
+poly_exp_t PolyFrozenDegBy(const PolyFrozen *p, size_t var_idx) {
+    if (p->root.size == 0 && p->root.coeff == 0) {
+        return -1;
+    }
+
+    return FrozenDegBy(p, p->root, p->leaf, var_idx);
+}
+
+bool PolyFrozenIsEq(const PolyFrozen *p, const PolyFrozen *q) {
+    if (p->root.size != q->root.size || p->count != q->count || p->leaves != q->leaves) {
+        return false;
+    }
+    else if (p->root.size == 0) {
+        return p->root.coeff == q->root.coeff;
+    }
+
+    return memcmp(p->block, q->block, FrozenBytes(p)) == 0;
+}
+
+/**
+ * Wylicza wartość liścia schematem Hornera, od najwyższego wykładnika.
+ * @param[in] f : wielomian zamrożony
+ * @param[in] ref : liść
+ * @param[in] x : wartość argumentu
+ * @return wartość liścia w punkcie @p x
+ */
+static poly_coeff_t FrozenLeafAt(const PolyFrozen *f, FrozenRef ref, poly_coeff_t x) {
+    const poly_coeff_t *coeffs = FrozenLeafCoeffs(f) + ref.offset;
+    const poly_exp_t *exps = FrozenLeafExps(f) + ref.offset;
+    poly_coeff_t value = 0;
+
+    for (size_t i = ref.size; i > 0; i--) {
+        value = (value + coeffs[i - 1]) * CoeffPower(x, exps[i - 1] - (i > 1 ? exps[i - 2] : 0));
+    }
+
+    return value;
+}
+
+Poly PolyFrozenAt(const PolyFrozen *p, poly_coeff_t x) {
+    if (p->root.size == 0) {
+        return PolyFromCoeff(p->root.coeff);
+    }
+    else if (p->leaf) {
+        return PolyFromCoeff(FrozenLeafAt(p, p->root, x));
+    }
+
+    // Jednomiany wszystkich przeskalowanych współczynników sumujemy naraz.
+    size_t count = 0;
+    for (size_t i = 0; i < p->root.size; i++) {
+        FrozenRef c = p->block[i].p;
+
+        count += c.size == 0 ? 1 : c.size;
+    }
+
+    Mono *monos = malloc(count * sizeof(Mono));
+    CHECK_PTR(monos);
+
+    size_t k = 0;
+    poly_exp_t exp = 0;
+    poly_coeff_t power = 1;
+
+    for (size_t i = 0; i < p->root.size; i++) {
+        const FrozenMono *m = &p->block[i];
+
+        power *= CoeffPower(x, m->exp - exp);
+        exp = m->exp;
+
+        if (m->p.size == 0) {
+            monos[k++] = (Mono) {.p = PolyFromCoeff(m->p.coeff * power), .exp = 0};
+        }
+        else if (m->leaf) {
+            const poly_coeff_t *coeffs = FrozenLeafCoeffs(p) + m->p.offset;
+            const poly_exp_t *exps = FrozenLeafExps(p) + m->p.offset;
+
+            for (size_t j = 0; j < m->p.size; j++) {
+                monos[k++] = (Mono) {.p = PolyFromCoeff(coeffs[j] * power), .exp = exps[j]};
+            }
+        }
+        else {
+            for (size_t j = 0; j < m->p.size; j++) {
+                const FrozenMono *c = &p->block[m->p.offset + j];
+
+                monos[k++] = (Mono) {.p = ThawScaled(p, c->p, c->leaf, power), .exp = c->exp};
+            }
+        }
+    }
+
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Wypisuje fragment bloku w formacie kalkulatora.
+ * @param[in] f : wielomian zamrożony
+ * @param[in] ref : współczynnik w bloku
+ * @param[in] leaf : czy @p ref jest liściem?
+ * @param[in] stream : strumień wyjściowy
+ */
+static void FrozenPrint(const PolyFrozen *f, FrozenRef ref, bool leaf, FILE *stream) {
+    if (ref.size == 0) {
+        fprintf(stream, "%ld", ref.coeff);
+    }
+    else if (leaf) {
+        const poly_coeff_t *coeffs = FrozenLeafCoeffs(f) + ref.offset;
+        const poly_exp_t *exps = FrozenLeafExps(f) + ref.offset;
+
+        for (size_t i = 0; i < ref.size; i++) {
+            fprintf(stream, i == 0 ? "(%ld,%d)" : "+(%ld,%d)", coeffs[i], exps[i]);
+        }
+    }
+    else {
+        for (size_t i = 0; i < ref.size; i++) {
+            const FrozenMono *m = &f->block[ref.offset + i];
+
+            fputs(i == 0 ? "(" : "+(", stream);
+            FrozenPrint(f, m->p, m->leaf, stream);
+            fprintf(stream, ",%d)", m->exp);
+        }
+    }
+}
+
+void PolyFrozenPrint(const PolyFrozen *p, FILE *stream) {
+    FrozenPrint(p, p->root, p->leaf, stream);
+}
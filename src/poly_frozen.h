@@ -0,0 +1,128 @@
+/** @file
+  Interfejs wielomianów zamrożonych
+
+  Wielomian zamrożony zajmuje jeden ciągły blok pamięci. Tablice jednomianów
+  są w nim ułożone w kolejności przeszukiwania w głąb: najpierw jednomiany
+  korzenia, a po każdej tablicy kolejno tablice jej współczynników wraz z ich
+  potomkami. Współczynniki wielomianowe wskazują swoje tablice przesunięciem
+  od początku bloku, więc blok można kopiować funkcją memcpy. Wielomian
+  zamrożony jest tylko do odczytu; kopia to jeden przydział pamięci, a jego
+  usunięcie to jedno zwolnienie. Współdzielone poddrzewa wielomianu są
+  w bloku powielane.
+
+  Liście drzewa, czyli tablice jednomianów o samych współczynnikach liczbowych,
+  są zapisane osobno, za tablicami jednomianów: w tablicy współczynników
+  i równoległej tablicy wykładników. Jednomian liścia zajmuje wtedy 12 zamiast
+  24 bajtów.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __POLY_FROZEN_H__
+#define __POLY_FROZEN_H__
+
+#include "poly.h"
+
+#include <stdio.h>
+
+/**
+ * Współczynnik w wielomianie zamrożonym.
+ */
+typedef struct FrozenRef {
+    size_t size; ///< liczba jednomianów; zero oznacza współczynnik liczbowy
+    union {
+        poly_coeff_t coeff; ///< współczynnik liczbowy, jeśli @p size jest zerem
+        size_t offset; ///< numer pierwszego jednomianu tablicy w bloku albo w tablicach liści
+    };
+} FrozenRef;
+
+/**
+ * Jednomian w wielomianie zamrożonym.
+ */
+typedef struct FrozenMono {
+    FrozenRef p; ///< współczynnik
+    poly_exp_t exp; ///< wykładnik
+    bool leaf; ///< czy współczynnik jest liściem?
+} FrozenMono;
+
+/**
+ * Wielomian zamrożony.
+ */
+typedef struct PolyFrozen {
+    FrozenRef root; ///< korzeń; jego tablica zaczyna się na początku bloku
+    bool leaf; ///< czy korzeń jest liściem?
+    size_t count; ///< liczba jednomianów w bloku poza liśćmi
+    size_t leaves; ///< liczba jednomianów liści
+    FrozenMono *block; ///< blok albo NULL
+} PolyFrozen;
+
+/**
+ * Zamraża wielomian.
+ * @param[in] p : wielomian
+ * @return wielomian zamrożony równy @p p
+ */
+PolyFrozen PolyFreeze(const Poly *p);
+
+/**
+ * Odtwarza zwykły wielomian z wielomianu zamrożonego.
+ * @param[in] p : wielomian zamrożony
+ * @return wielomian równy @p p
+ */
+Poly PolyThaw(const PolyFrozen *p);
+
+/**
+ * Robi kopię wielomianu zamrożonego jednym kopiowaniem bloku.
+ * @param[in] p : wielomian zamrożony
+ * @return kopia @p p
+ */
+PolyFrozen PolyFrozenClone(const PolyFrozen *p);
+
+/**
+ * Usuwa wielomian zamrożony z pamięci.
+ * @param[in] p : wielomian zamrożony
+ */
+void PolyFrozenDestroy(PolyFrozen *p);
+
+/**
+ * Zwraca stopień wielomianu zamrożonego (-1 dla wielomianu tożsamościowo
+ * równego zeru).
+ * @param[in] p : wielomian zamrożony
+ * @return stopień wielomianu @p p
+ */
+poly_exp_t PolyFrozenDeg(const PolyFrozen *p);
+
+/**
+ * Zwraca stopień wielomianu zamrożonego ze względu na zadaną zmienną (-1 dla
+ * wielomianu tożsamościowo równego zeru).
+ * @param[in] p : wielomian zamrożony
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ */
+poly_exp_t PolyFrozenDegBy(const PolyFrozen *p, size_t var_idx);
+
+/**
+ * Sprawdza równość dwóch wielomianów zamrożonych. Równe wielomiany mają
+ * identyczne bloki, więc wystarczy porównać pamięć.
+ * @param[in] p : wielomian zamrożony @f$p@f$
+ * @param[in] q : wielomian zamrożony @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyFrozenIsEq(const PolyFrozen *p, const PolyFrozen *q);
+
+/**
+ * Wylicza wartość wielomianu zamrożonego w punkcie @p x (zob. PolyAt).
+ * @param[in] p : wielomian zamrożony @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyFrozenAt(const PolyFrozen *p, poly_coeff_t x);
+
+/**
+ * Wypisuje wielomian zamrożony w formacie kalkulatora, bez znaku końca wiersza.
+ * @param[in] p : wielomian zamrożony
+ * @param[in] stream : strumień wyjściowy
+ */
+void PolyFrozenPrint(const PolyFrozen *p, FILE *stream);
+
+#endif /* __POLY_FROZEN_H__ */
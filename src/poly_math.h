@@ -0,0 +1,51 @@
+/** @file
+  Definicje pomocniczych operacji arytmetycznych używanych przez moduły
+  wielomianów.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __POLY_MATH_H__
+#define __POLY_MATH_H__
+
+#include "poly.h"
+
+/**
+ * Zwraca maksimum z dwóch liczb.
+ * @param[in] x : liczba
+ * @param[in] y : liczba
+ * @return @f$ \max(x, y) @f$
+ */
+#define MAX(x, y) (((x) >= (y)) ? (x) : (y))
+
+/**
+ * Zwraca minimum z dwóch liczb.
+ * @param[in] x : liczba
+ * @param[in] y : liczba
+ * @return @f$ \min(x, y) @f$
+ */
+#define MIN(x, y) (((x) <= (y)) ? (x) : (y))
+
+/**
+ * Podnosi liczbę do potęgi.
+ * @param[in] base : podstawa
+ * @param[in] exponent : wykładnik
+ * @return @f$ \text{base} ^ {\text{exponent}} @f$
+ */
+static inline poly_coeff_t CoeffPower(poly_coeff_t base, poly_exp_t exponent) {
+    poly_coeff_t result = 1;
+
+    while (exponent > 0) {
+        if (exponent % 2 == 1) {
+            result *= base;
+        }
+
+        base *= base;
+        exponent /= 2;
+    }
+
+    return result;
+}
+
+#endif /* __POLY_MATH_H__ */
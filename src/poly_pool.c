@@ -0,0 +1,192 @@
+/** @file
+  Implementacja puli pamięci na tablice jednomianów
+
+  Klasa @f$c@f$ obejmuje bloki o rozmiarze @f$c \cdot@f$ POOL_GRANULE bajtów.
+  Bloki wszystkich klas są wycinane kolejno z kawałków o rozmiarze
+  POOL_CHUNK_SIZE, a wolne bloki tworzą listy jednokierunkowe zapisane
+  w samych blokach. Pamięć kawałków jest oddawana systemowi dopiero przez
+  PolyPoolTrim.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "poly_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Różnica rozmiarów bloków kolejnych klas w bajtach.
+ */
+#define POOL_GRANULE 16
+
+/**
+ * Liczba klas. Bloki większe niż POOL_CLASSES * POOL_GRANULE bajtów są
+ * przydzielane funkcją malloc.
+ */
+#define POOL_CLASSES 32
+
+/**
+ * Rozmiar kawałka pamięci, z którego są wycinane bloki, w bajtach.
+ */
+#define POOL_CHUNK_SIZE ((size_t)64 << 10)
+
+/**
+ * Wolny blok puli.
+ */
+typedef struct PoolBlock {
+    struct PoolBlock *next; ///< następny wolny blok tej samej klasy
+} PoolBlock;
+
+/**
+ * Kawałek pamięci puli.
+ */
+typedef struct PoolChunk {
+    struct PoolChunk *prev; ///< poprzednio przydzielony kawałek
+    size_t used; ///< liczba bajtów zajętych przez wycięte bloki
+} PoolChunk;
+
+/**
+ * Pula wątku.
+ */
+typedef struct Pool {
+    PoolBlock *free[POOL_CLASSES + 1]; ///< listy wolnych bloków klas
+    PoolChunk *chunk; ///< bieżący kawałek albo NULL
+    PolyPoolStats stats; ///< statystyki
+} Pool;
+
+/**
+ * Pula bieżącego wątku.
+ */
+static _Thread_local Pool pool;
+
+/**
+ * Przydziela blok danej klasy z puli.
+ * @param[in] size_class : klasa
+ * @return blok
+ */
+static void *PoolAlloc(unsigned size_class) {
+    size_t size = size_class * POOL_GRANULE;
+
+    pool.stats.in_use += size;
+
+    if (pool.free[size_class] != NULL) {
+        PoolBlock *block = pool.free[size_class];
+
+        pool.free[size_class] = block->next;
+        pool.stats.hits++;
+
+        return block;
+    }
+
+    pool.stats.misses++;
+
+    if (pool.chunk == NULL || POOL_CHUNK_SIZE - pool.chunk->used < size) {
+        PoolChunk *chunk = malloc(sizeof(PoolChunk) + POOL_CHUNK_SIZE);
+        CHECK_PTR(chunk);
+
+        chunk->prev = pool.chunk;
+        chunk->used = 0;
+        pool.chunk = chunk;
+        pool.stats.resident += POOL_CHUNK_SIZE;
+    }
+
+    // Nagłówek kawałka ma rozmiar 16 bajtów, więc bloki są wyrównane tak jak
+    // wyniki funkcji malloc.
+    void *block = (char *)(pool.chunk + 1) + pool.chunk->used;
+
+    pool.chunk->used += size;
+
+    return block;
+}
+
+/**
+ * Zwraca blok danej klasy do puli.
+ * @param[in] ptr : blok
+ * @param[in] size_class : klasa
+ */
+static void PoolFree(void *ptr, unsigned size_class) {
+    PoolBlock *block = ptr;
+
+    block->next = pool.free[size_class];
+    pool.free[size_class] = block;
+    pool.stats.in_use -= size_class * POOL_GRANULE;
+}
+
+void *PolyPoolResize(void *ptr, unsigned char *size_class, size_t size) {
+    unsigned old_class = ptr == NULL ? 0 : *size_class;
+    unsigned new_class = size == 0 || size > POOL_CLASSES * POOL_GRANULE
+                         ? 0 : (size + POOL_GRANULE - 1) / POOL_GRANULE;
+
+    if (ptr != NULL && old_class == 0 && new_class == 0) {
+        if (size == 0) {
+            free(ptr);
+
+            return NULL;
+        }
+
+        void *moved = realloc(ptr, size);
+        CHECK_PTR(moved);
+
+        return moved;
+    }
+    else if (ptr != NULL && old_class != 0 && old_class == new_class) {
+        return ptr;
+    }
+
+    void *result = NULL;
+
+    if (new_class != 0) {
+        result = PoolAlloc(new_class);
+    }
+    else if (size > 0) {
+        result = malloc(size);
+        CHECK_PTR(result);
+
+        pool.stats.bypassed++;
+    }
+
+    if (ptr != NULL) {
+        size_t old_size = old_class * POOL_GRANULE;
+
+        if (result != NULL) {
+            memcpy(result, ptr, old_class == 0 || old_size > size ? size : old_size);
+        }
+
+        if (old_class == 0) {
+            free(ptr);
+        }
+        else {
+            PoolFree(ptr, old_class);
+        }
+    }
+
+    *size_class = new_class;
+
+    return result;
+}
+
+size_t PolyPoolBlockSize(unsigned char size_class, size_t size) {
+    return size_class == 0 ? size : size_class * POOL_GRANULE;
+}
+
+PolyPoolStats PolyPoolGetStats(void) {
+    return pool.stats;
+}
+
+void PolyPoolTrim(void) {
+    if (pool.stats.in_use > 0) {
+        return;
+    }
+
+    while (pool.chunk != NULL) {
+        PoolChunk *prev = pool.chunk->prev;
+
+        free(pool.chunk);
+        pool.chunk = prev;
+    }
+
+    memset(&pool, 0, sizeof(Pool));
+}
@@ -0,0 +1,65 @@
+/** @file
+  Interfejs puli pamięci na tablice jednomianów
+
+  Małe bloki są przydzielane z pul o stałych rozmiarach (klasach) wycinanych
+  z dużych kawałków pamięci, a zwolnione bloki trafiają na listę wolnych
+  bloków swojej klasy i są ponownie używane przy następnym przydziale tej
+  klasy. Większe bloki są przydzielane funkcją malloc. Każdy wątek ma własną
+  pulę, więc blok należy zwolnić w wątku, w którym go przydzielono
+  (zob. model wątków opisany w poly.h).
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __POLY_POOL_H__
+#define __POLY_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * Statystyki puli bieżącego wątku.
+ */
+typedef struct PolyPoolStats {
+    size_t hits; ///< liczba przydziałów z listy wolnych bloków
+    size_t misses; ///< liczba przydziałów wyciętych z nowej pamięci puli
+    size_t bypassed; ///< liczba przydziałów zbyt dużych na pulę
+    size_t in_use; ///< łączny rozmiar używanych bloków z puli w bajtach
+    size_t resident; ///< łączny rozmiar pamięci zajmowanej przez pulę w bajtach
+} PolyPoolStats;
+
+/**
+ * Przydziela, zmienia rozmiar albo zwalnia blok pamięci. Dla @p ptr równego
+ * NULL przydziela nowy blok, a dla zerowego @p size zwalnia blok @p ptr.
+ * Zawartość bloku jest zachowywana jak przy funkcji realloc. Numer klasy
+ * bloku (zero dla bloków spoza puli) musi być przechowywany przez
+ * wywołującego i przekazywany przy każdej zmianie bloku.
+ * @param[in] ptr : blok albo NULL
+ * @param[in, out] size_class : klasa bloku @p ptr; po wywołaniu klasa wyniku
+ * @param[in] size : nowy rozmiar w bajtach
+ * @return blok o rozmiarze co najmniej @p size albo NULL
+ */
+void *PolyPoolResize(void *ptr, unsigned char *size_class, size_t size);
+
+/**
+ * Zwraca rzeczywisty rozmiar bloku o danej klasie przydzielonego dla
+ * @p size bajtów.
+ * @param[in] size_class : klasa bloku (zero dla bloków spoza puli)
+ * @param[in] size : rozmiar, o który prosiła funkcja PolyPoolResize
+ * @return rozmiar bloku w bajtach
+ */
+size_t PolyPoolBlockSize(unsigned char size_class, size_t size);
+
+/**
+ * Zwraca statystyki puli bieżącego wątku.
+ * @return statystyki
+ */
+PolyPoolStats PolyPoolGetStats(void);
+
+/**
+ * Oddaje systemowi pamięć puli bieżącego wątku, o ile żaden jej blok nie jest
+ * używany, i zeruje liczniki.
+ */
+void PolyPoolTrim(void);
+
+#endif /* __POLY_POOL_H__ */
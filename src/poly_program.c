@@ -0,0 +1,293 @@
+/** @file
+  Implementacja programów wyliczających wartości wielomianów
+
+  Wielomian @f$\sum_i c_i x^{e_i}@f$ o wykładnikach @f$e_0 < \dots < e_{n-1}@f$
+  jest tłumaczony na ciąg
+  @f$(\dots(c_{n-1} x^{e_{n-1} - e_{n-2}} + c_{n-2}) \dots + c_0) x^{e_0}@f$,
+  gdzie każdy współczynnik @f$c_i@f$ niebędący liczbą jest tłumaczony
+  rekurencyjnie ze względu na następną zmienną.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#include "check_ptr.h"
+#include "poly_math.h"
+#include "poly_program.h"
+
+#include <stdlib.h>
+
+/**
+ * Liczba punktów przetwarzanych razem przez jedną instrukcję.
+ */
+#define BATCH_SIZE 64
+
+/**
+ * Początkowa pojemność tablic programu.
+ */
+#define INITIAL_CAPACITY 16
+
+/**
+ * Zwraca wskaźnik na nowy element tablicy, w razie potrzeby ją powiększając.
+ * @param[in, out] arr : wskaźnik na tablicę
+ * @param[in, out] size : liczba elementów tablicy
+ * @param[in, out] capacity : pojemność tablicy
+ * @param[in] element_size : rozmiar elementu
+ * @return wskaźnik na nowy element
+ */
+static void* ArrayPush(void **arr, size_t *size, size_t *capacity, size_t element_size) {
+    if (*size == *capacity) {
+        *capacity = *capacity == 0 ? INITIAL_CAPACITY : 2 * *capacity;
+        *arr = realloc(*arr, *capacity * element_size);
+        CHECK_PTR(*arr);
+    }
+
+    return (char*)*arr + (*size)++ * element_size;
+}
+
+/**
+ * Porównuje potęgi najpierw po zmiennych, a potem po wykładnikach.
+ * @param[in] a : wskaźnik na potęgę
+ * @param[in] b : wskaźnik na potęgę
+ * @return liczba ujemna, zero lub dodatnia, gdy @p a jest odpowiednio
+ * mniejsza, równa lub większa od @p b
+ */
+static int PowerCompare(const void *a, const void *b) {
+    const PolyPower *x = a;
+    const PolyPower *y = b;
+
+    if (x->var != y->var) {
+        return x->var < y->var ? -1 : 1;
+    }
+
+    return (x->exp > y->exp) - (x->exp < y->exp);
+}
+
+/**
+ * Dopisuje do programu potęgi zmiennych potrzebne do wyliczenia wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej wielomianu
+ * @param[in, out] program : program
+ * @param[in, out] capacity : pojemność tablicy potęg
+ */
+static void CollectPowers(const Poly *p, size_t var, PolyProgram *program, size_t *capacity) {
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t gap = MonoGetExp(&p->arr[i]) - (i > 0 ? MonoGetExp(&p->arr[i - 1]) : 0);
+
+        if (gap > 0) {
+            PolyPower *power = ArrayPush((void**)&program->powers, &program->powers_count,
+                                         capacity, sizeof(PolyPower));
+            *power = (PolyPower) {.var = var, .exp = gap};
+        }
+
+        CollectPowers(&p->arr[i].p, var + 1, program, capacity);
+    }
+
+    if (var + 1 > program->vars) {
+        program->vars = var + 1;
+    }
+}
+
+/**
+ * Dopisuje instrukcję do programu.
+ * @param[in, out] program : program
+ * @param[in, out] capacity : pojemność tablicy instrukcji
+ * @param[in] op : kod instrukcji
+ * @param[in] arg : argument instrukcji
+ */
+static void Emit(PolyProgram *program, size_t *capacity, PolyOpcode op, poly_coeff_t arg) {
+    PolyInstruction *instruction = ArrayPush((void**)&program->code, &program->size,
+                                             capacity, sizeof(PolyInstruction));
+    *instruction = (PolyInstruction) {.arg = arg, .op = op};
+}
+
+/**
+ * Dopisuje instrukcję mnożenia przez potęgę zmiennej.
+ * @param[in, out] program : program z kompletną tablicą potęg
+ * @param[in, out] capacity : pojemność tablicy instrukcji
+ * @param[in] var : numer zmiennej
+ * @param[in] exp : wykładnik (dodatni)
+ */
+static void EmitMulPow(PolyProgram *program, size_t *capacity, size_t var, poly_exp_t exp) {
+    PolyPower key = {.var = var, .exp = exp};
+    PolyPower *power = bsearch(&key, program->powers, program->powers_count,
+                               sizeof(PolyPower), PowerCompare);
+
+    Emit(program, capacity, OP_MUL_POW, power - program->powers);
+}
+
+/**
+ * Dopisuje do programu instrukcje wstawiające na stos wartość wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej wielomianu
+ * @param[in] height : wysokość stosu przed wykonaniem instrukcji
+ * @param[in, out] program : program z kompletną tablicą potęg
+ * @param[in, out] capacity : pojemność tablicy instrukcji
+ */
+static void EmitPoly(const Poly *p, size_t var, size_t height, PolyProgram *program, size_t *capacity) {
+    if (height + 1 > program->depth) {
+        program->depth = height + 1;
+    }
+
+    if (PolyIsCoeff(p)) {
+        Emit(program, capacity, OP_CONST, p->coeff);
+
+        return;
+    }
+
+    EmitPoly(&p->arr[p->size - 1].p, var + 1, height, program, capacity);
+
+    for (size_t i = p->size - 1; i > 0; i--) {
+        EmitMulPow(program, capacity, var, MonoGetExp(&p->arr[i]) - MonoGetExp(&p->arr[i - 1]));
+
+        const Poly *c = &p->arr[i - 1].p;
+        if (PolyIsCoeff(c)) {
+            Emit(program, capacity, OP_ADD_CONST, c->coeff);
+        }
+        else {
+            EmitPoly(c, var + 1, height + 1, program, capacity);
+            Emit(program, capacity, OP_ADD, 0);
+        }
+    }
+
+    if (MonoGetExp(&p->arr[0]) > 0) {
+        EmitMulPow(program, capacity, var, MonoGetExp(&p->arr[0]));
+    }
+}
+
+PolyProgram PolyCompile(const Poly *p) {
+    PolyProgram program = {
+        .size = 0, .code = NULL, .powers_count = 0, .powers = NULL, .depth = 0, .vars = 0
+    };
+    size_t capacity = 0;
+
+    CollectPowers(p, 0, &program, &capacity);
+
+    if (program.powers_count > 0) {
+        qsort(program.powers, program.powers_count, sizeof(PolyPower), PowerCompare);
+
+        size_t count = 1;
+        for (size_t i = 1; i < program.powers_count; i++) {
+            if (PowerCompare(&program.powers[i], &program.powers[count - 1]) != 0) {
+                program.powers[count++] = program.powers[i];
+            }
+        }
+        program.powers_count = count;
+    }
+
+    capacity = 0;
+    EmitPoly(p, 0, 0, &program, &capacity);
+
+    return program;
+}
+
+void PolyProgramDestroy(PolyProgram *program) {
+    free(program->code);
+    free(program->powers);
+}
+
+/**
+ * Wylicza potęgi zmiennych dla paczki punktów. Potęga zmiennej jest
+ * wyliczana z poprzedniej potęgi tej samej zmiennej, więc wystarcza
+ * podniesienie zmiennej do różnicy wykładników.
+ * @param[in] program : program
+ * @param[in] m : liczba punktów w paczce
+ * @param[in] k : liczba wartości w każdym punkcie
+ * @param[in] xs : punkty paczki
+ * @param[out] powers : tablica na potęgi, po BATCH_SIZE wartości na potęgę
+ */
+static void ComputePowers(const PolyProgram *program, size_t m, size_t k, const poly_coeff_t xs[],
+                          poly_coeff_t powers[]) {
+    for (size_t s = 0; s < program->powers_count; s++) {
+        size_t var = program->powers[s].var;
+        poly_coeff_t *row = powers + s * BATCH_SIZE;
+
+        if (var >= k) {
+            for (size_t j = 0; j < m; j++) {
+                row[j] = 0;
+            }
+        }
+        else if (s > 0 && program->powers[s - 1].var == var) {
+            const poly_coeff_t *prev = row - BATCH_SIZE;
+            poly_exp_t gap = program->powers[s].exp - program->powers[s - 1].exp;
+
+            for (size_t j = 0; j < m; j++) {
+                row[j] = prev[j] * CoeffPower(xs[j * k + var], gap);
+            }
+        }
+        else {
+            poly_exp_t exp = program->powers[s].exp;
+
+            for (size_t j = 0; j < m; j++) {
+                row[j] = CoeffPower(xs[j * k + var], exp);
+            }
+        }
+    }
+}
+
+size_t PolyProgramArity(const PolyProgram *program) {
+    return program->vars > 0 ? program->vars : 1;
+}
+
+void PolyProgramRun(const PolyProgram *program, size_t n, size_t k, const poly_coeff_t xs[],
+                    poly_coeff_t out[]) {
+    poly_coeff_t *memory = malloc((program->powers_count + program->depth) * BATCH_SIZE
+                                  * sizeof(poly_coeff_t));
+    CHECK_PTR(memory);
+
+    poly_coeff_t *powers = memory;
+    poly_coeff_t *stack = memory + program->powers_count * BATCH_SIZE;
+
+    for (size_t b = 0; b < n; b += BATCH_SIZE) {
+        size_t m = n - b < BATCH_SIZE ? n - b : BATCH_SIZE;
+        size_t height = 0;
+
+        ComputePowers(program, m, k, xs + b * k, powers);
+
+        for (size_t i = 0; i < program->size; i++) {
+            poly_coeff_t arg = program->code[i].arg;
+            poly_coeff_t *top;
+
+            switch (program->code[i].op) {
+                case OP_CONST:
+                    top = stack + height++ * BATCH_SIZE;
+                    for (size_t j = 0; j < m; j++) {
+                        top[j] = arg;
+                    }
+                    break;
+                case OP_ADD_CONST:
+                    top = stack + (height - 1) * BATCH_SIZE;
+                    for (size_t j = 0; j < m; j++) {
+                        top[j] += arg;
+                    }
+                    break;
+                case OP_ADD:
+                    height--;
+                    top = stack + (height - 1) * BATCH_SIZE;
+                    for (size_t j = 0; j < m; j++) {
+                        top[j] += top[j + BATCH_SIZE];
+                    }
+                    break;
+                case OP_MUL_POW: {
+                    const poly_coeff_t *power = powers + arg * BATCH_SIZE;
+
+                    top = stack + (height - 1) * BATCH_SIZE;
+                    for (size_t j = 0; j < m; j++) {
+                        top[j] *= power[j];
+                    }
+                    break;
+                }
+            }
+        }
+
+        for (size_t j = 0; j < m; j++) {
+            out[b + j] = stack[j];
+        }
+    }
+
+    free(memory);
+}
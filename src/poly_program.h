@@ -0,0 +1,94 @@
+/** @file
+  Interfejs programów wyliczających wartości wielomianów
+
+  Program to płaska tablica instrukcji maszyny stosowej, która wylicza
+  wartość wielomianu schematem Hornera ze względu na kolejne zmienne.
+  Potęgi zmiennych potrzebne w programie są wyliczane raz dla każdego
+  punktu i współdzielone przez wszystkie instrukcje. Program wylicza wartości
+  w wielu punktach naraz: każda instrukcja jest wykonywana dla całej paczki
+  punktów, zanim zostanie wykonana następna.
+
+  @author Jakub Jagiełła
+  @date 2021
+*/
+
+#ifndef __POLY_PROGRAM_H__
+#define __POLY_PROGRAM_H__
+
+#include "poly.h"
+
+/**
+ * Kody instrukcji programu.
+ */
+typedef enum PolyOpcode {
+    OP_CONST, ///< wstawia współczynnik na stos
+    OP_ADD_CONST, ///< dodaje współczynnik do wierzchołka stosu
+    OP_ADD, ///< zdejmuje wierzchołek stosu i dodaje go do elementu pod nim
+    OP_MUL_POW ///< mnoży wierzchołek stosu przez potęgę zmiennej
+} PolyOpcode;
+
+/**
+ * Instrukcja programu.
+ */
+typedef struct PolyInstruction {
+    poly_coeff_t arg; ///< współczynnik albo numer potęgi, zależnie od kodu
+    PolyOpcode op; ///< kod instrukcji
+} PolyInstruction;
+
+/**
+ * Potęga zmiennej używana w programie.
+ */
+typedef struct PolyPower {
+    size_t var; ///< numer zmiennej
+    poly_exp_t exp; ///< wykładnik
+} PolyPower;
+
+/**
+ * Program wyliczający wartość wielomianu.
+ */
+typedef struct PolyProgram {
+    size_t size; ///< liczba instrukcji
+    PolyInstruction *code; ///< instrukcje
+    size_t powers_count; ///< liczba potęg
+    PolyPower *powers; ///< potęgi posortowane po zmiennych i wykładnikach
+    size_t depth; ///< największa wysokość stosu podczas wykonania
+    size_t vars; ///< liczba zmiennych, od których zależy wynik
+} PolyProgram;
+
+/**
+ * Tłumaczy wielomian na program wyliczający jego wartość.
+ * @param[in] p : wielomian
+ * @return program
+ */
+PolyProgram PolyCompile(const Poly *p);
+
+/**
+ * Usuwa program z pamięci.
+ * @param[in] program : program
+ */
+void PolyProgramDestroy(PolyProgram *program);
+
+/**
+ * Podaje, z ilu wartości składa się jeden punkt, w którym program jest
+ * uruchamiany: z tylu, od ilu zmiennych zależy wielomian, ale co najmniej
+ * z jednej, więc program stałej daje jedną wartość na każdą podaną wartość.
+ * @param[in] program : program
+ * @return liczba wartości w jednym punkcie
+ */
+size_t PolyProgramArity(const PolyProgram *program);
+
+/**
+ * Wylicza wartości wielomianu w @p n punktach. Punkt @f$j@f$ to wartości
+ * @p xs[j * k], ..., @p xs[j * k + k - 1] kolejnych zmiennych, a pod zmienne
+ * o indeksach większych lub równych @p k podstawiane jest zero, tak jak
+ * w funkcji PolyEval.
+ * @param[in] program : program
+ * @param[in] n : liczba punktów
+ * @param[in] k : liczba wartości w każdym punkcie
+ * @param[in] xs : punkty
+ * @param[out] out : tablica na @p n wartości
+ */
+void PolyProgramRun(const PolyProgram *program, size_t n, size_t k, const poly_coeff_t xs[],
+                    poly_coeff_t out[]);
+
+#endif /* __POLY_PROGRAM_H__ */
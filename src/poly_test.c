@@ -2,7 +2,14 @@
 #undef NDEBUG
 #endif
 
+#include "arena.h"
+#include "calc_functions.h"
+#include "dense.h"
 #include "poly.h"
+#include "poly_cache.h"
+#include "poly_frozen.h"
+#include "poly_pool.h"
+#include "poly_program.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -3967,6 +3974,1099 @@ static bool MemoryFreeTest(void) {
   return res;
 }
 
+/**
+ * Tworzy wielomian o @p count jednomianach stopni @f$0, s, 2s, \dots@f$,
+ * gdzie @f$s@f$ to @p step. Na głębokości zero współczynniki są nieparzystymi
+ * liczbami, a na większych głębokościach wielomianami tworzonymi tą samą
+ * funkcją z trzema jednomianami i głębokością o jeden mniejszą.
+ * @param count liczba jednomianów
+ * @param step odstęp między wykładnikami
+ * @param depth głębokość zagnieżdżenia współczynników
+ * @return wielomian
+ */
+static Poly GeneratedPoly(size_t count, poly_exp_t step, size_t depth) {
+  Mono *monos = malloc(count * sizeof (Mono));
+  CHECK_PTR(monos);
+  for (size_t i = 0; i < count; ++i) {
+    poly_coeff_t c = (poly_coeff_t)(i * 0x9E3779B97F4A7C15UL) | 1;
+    Poly p = depth == 0 ? C(c) : GeneratedPoly(3, 2, depth - 1);
+    monos[i] = M(p, (poly_exp_t)i * step);
+  }
+  return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Porównuje wyniki operacji przejmujących argumenty na własność
+ * z wynikami ich odpowiedników niemodyfikujących argumentów.
+ */
+static bool OwnArithmeticTest(void) {
+  Poly polys[] = {
+    C(0),
+    C(5),
+    C(1L << 63),
+    P(C(1), 0, C(2), 3),
+    P(C(-1), 0, C(-2), 3),
+    P(C(2), 1, P(C(1), 2), 3),
+    P(P(C(1), 0, C(3), 1), 0, C(7), 2),
+    P(P(C(-1), 0, C(-3), 1), 0, C(-7), 2, C(4), 5),
+    P(C(1L << 62), 1, P(C(2), 0, C(2), 1), 2),
+  };
+  const size_t count = sizeof (polys) / sizeof (polys)[0];
+  bool res = true;
+  for (size_t i = 0; i < count; ++i) {
+    Poly neg = PolyNeg(&polys[i]);
+    Poly neg_own = PolyNegOwn(PolyClone(&polys[i]));
+    res &= PolyIsEq(&neg, &neg_own);
+    PolyDestroy(&neg);
+    PolyDestroy(&neg_own);
+    for (size_t j = 0; j < count; ++j) {
+      Poly add = PolyAdd(&polys[i], &polys[j]);
+      Poly add_own = PolyAddOwn(PolyClone(&polys[i]), PolyClone(&polys[j]));
+      Poly sub = PolySub(&polys[i], &polys[j]);
+      Poly sub_own = PolySubOwn(PolyClone(&polys[i]), PolyClone(&polys[j]));
+      Poly mul = PolyMul(&polys[i], &polys[j]);
+      Poly mul_own = PolyMulOwn(PolyClone(&polys[i]), PolyClone(&polys[j]));
+      res &= PolyIsEq(&add, &add_own);
+      res &= PolyIsEq(&sub, &sub_own);
+      res &= PolyIsEq(&mul, &mul_own);
+      PolyDestroy(&add);
+      PolyDestroy(&add_own);
+      PolyDestroy(&sub);
+      PolyDestroy(&sub_own);
+      PolyDestroy(&mul);
+      PolyDestroy(&mul_own);
+    }
+  }
+  for (size_t i = 0; i < count; ++i)
+    PolyDestroy(&polys[i]);
+  return res;
+}
+
+/**
+ * Sprawdza akumulowanie sum i iloczynów w miejscu.
+ */
+static bool AccumulateTest(void) {
+  Poly polys[] = {
+    C(3),
+    P(C(1), 0, C(2), 3),
+    P(C(-1), 0, C(-2), 3),
+    P(P(C(1), 0, C(3), 1), 0, C(7), 2),
+    C(-3),
+    P(C(1L << 62), 1, P(C(2), 0, C(2), 1), 2),
+    P(C(1L << 62), 1, P(C(2), 0, C(2), 1), 2),
+  };
+  const size_t count = sizeof (polys) / sizeof (polys)[0];
+  bool res = true;
+  Poly sum = C(0);
+  Poly acc = C(0);
+  Poly fma = C(0);
+  Poly fma_acc = C(0);
+  for (size_t i = 0; i < count; ++i) {
+    Poly t = PolyAdd(&sum, &polys[i]);
+    PolyDestroy(&sum);
+    sum = t;
+    PolyAddTo(&acc, &polys[i]);
+    res &= PolyIsEq(&sum, &acc);
+    Poly m = PolyMul(&polys[i], &polys[count - i - 1]);
+    t = PolyAdd(&fma, &m);
+    PolyDestroy(&fma);
+    PolyDestroy(&m);
+    fma = t;
+    PolyFma(&fma_acc, &polys[i], &polys[count - i - 1]);
+    res &= PolyIsEq(&fma, &fma_acc);
+  }
+  PolyDestroy(&sum);
+  PolyDestroy(&acc);
+  PolyDestroy(&fma);
+  PolyDestroy(&fma_acc);
+  for (size_t i = 0; i < count; ++i)
+    PolyDestroy(&polys[i]);
+  return res;
+}
+
+/**
+ * Sumuje jednomiany funkcjami PolyCloneMonos, PolyAddMonos i PolyOwnMonos
+ * i porównuje wyniki z sumowaniem kolejnych jednomianów funkcją PolyAdd.
+ * Przejmuje na własność tablicę @p monos zaalokowaną na stercie
+ * wraz z jej zawartością.
+ * @param count liczba jednomianów
+ * @param monos tablica jednomianów
+ * @return czy wszystkie trzy sumy są poprawne
+ */
+static bool MonosSumMatches(size_t count, Mono *monos) {
+  bool res = true;
+  Mono *add = calloc(count, sizeof (Mono));
+  CHECK_PTR(add);
+  Poly expected = C(0);
+  for (size_t i = 0; i < count; ++i) {
+    add[i] = MonoClone(&monos[i]);
+    Poly m = P(PolyClone(&monos[i].p), MonoGetExp(&monos[i]));
+    Poly t = PolyAdd(&expected, &m);
+    PolyDestroy(&expected);
+    PolyDestroy(&m);
+    expected = t;
+  }
+  Poly sum = PolyCloneMonos(count, monos);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  sum = PolyAddMonos(count, add);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  free(add);
+  sum = PolyOwnMonos(count, monos);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  PolyDestroy(&expected);
+  return res;
+}
+
+/**
+ * Sumuje listy jednomianów o powtarzających się wykładnikach
+ * i porównuje wynik z sumowaniem kolejnych jednomianów.
+ */
+static bool AddMonosCollisionTest(void) {
+  const size_t count = 1000;
+  Mono *monos = calloc(count, sizeof (Mono));
+  CHECK_PTR(monos);
+  for (size_t i = 0; i < count; ++i) {
+    poly_coeff_t c = (i % 2 == 0 ? 1 : -1) * (poly_coeff_t)(i % 7 + 1);
+    Poly p = i % 3 == 0 ? C(c) : P(C(c), (poly_exp_t)(i % 5), C(1), 7);
+    monos[i] = M(p, (poly_exp_t)(i * 31 % 17));
+  }
+  return MonosSumMatches(count, monos);
+}
+
+static bool HornerAtTest(void) {
+  bool res = true;
+  res &= TestAt(P(C(5), 0, C(-3), 7, C(2), 40), 3,
+                C((poly_coeff_t)(5UL - 3UL * 2187UL + 2UL * 12157665459056928801UL)));
+  res &= TestAt(P(C(1), 1, C(1), 64, C(1), 100), 2, C(2));
+  res &= TestAt(P(C(7), 3), 0, C(0));
+  res &= TestAt(P(P(C(1), 1), 0, C(1), 63, P(C(1), 2), 64), 2,
+                P(C((poly_coeff_t)(1UL << 63)), 0, C(1), 1));
+  res &= TestAt(P(P(C(-8), 1), 0, P(C(2), 1), 2), 2, C(0));
+  return res;
+}
+
+static bool AtManyTest(void) {
+  bool res = true;
+  const poly_coeff_t xs[] = {0, 1, -1, 2, 3, -7, 1L << 32};
+  const size_t n = sizeof (xs) / sizeof (xs)[0];
+  Poly polys[] = {
+    C(5),
+    P(C(5), 0, C(-3), 7, C(2), 40),
+    P(C(1), 1, C(1), 64),
+    P(P(C(1), 1), 0, C(4), 3, P(C(1), 2, C(-1), 5), 9)
+  };
+  Poly out[sizeof (xs) / sizeof (xs)[0]];
+  for (size_t i = 0; i < sizeof (polys) / sizeof (polys)[0]; ++i) {
+    PolyAtMany(&polys[i], xs, n, out);
+    for (size_t j = 0; j < n; ++j) {
+      Poly expected = PolyAt(&polys[i], xs[j]);
+      res &= PolyIsEq(&out[j], &expected);
+      PolyDestroy(&expected);
+      PolyDestroy(&out[j]);
+    }
+    PolyDestroy(&polys[i]);
+  }
+  return res;
+}
+
+static bool EvalTest(void) {
+  bool res = true;
+  const poly_coeff_t x[] = {2, -3, 5};
+  Poly p = P(C(3), 0, P(C(1), 2), 1, P(C(2), 0, P(C(1), 1, C(-4), 2), 3), 4);
+  p = PolyAddOwn(p, C(7));
+  for (size_t k = 0; k <= 3; ++k) {
+    Poly q = PolyClone(&p);
+    for (size_t i = 0; i < 3; ++i) {
+      Poly t = PolyAt(&q, i < k ? x[i] : 0);
+      PolyDestroy(&q);
+      q = t;
+    }
+    res &= PolyIsCoeff(&q) && PolyEval(&p, x, k) == q.coeff;
+    PolyDestroy(&q);
+  }
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool CompileTest(void) {
+  bool res = true;
+  Poly polys[] = {
+    C(-4),
+    P(C(5), 0, C(-3), 7, C(2), 40),
+    P(C(3), 0, P(C(1), 2), 1, P(C(2), 0, P(C(1), 1, C(-4), 2), 3), 4),
+    P(P(P(C(1), 1), 3), 2, P(C(7), 0, C(1), 3), 5)
+  };
+  const size_t arities[] = {1, 1, 3, 3};
+  const size_t n = 100;
+  const size_t k = 3;
+  poly_coeff_t xs[300];
+  poly_coeff_t out[100];
+  for (size_t j = 0; j < n * k; ++j)
+    xs[j] = (poly_coeff_t)(j * 7919 % 23) - 11;
+  for (size_t i = 0; i < sizeof (polys) / sizeof (polys)[0]; ++i) {
+    PolyProgram program = PolyCompile(&polys[i]);
+    PolyProgramRun(&program, n, k, xs, out);
+    for (size_t j = 0; j < n; ++j)
+      res &= out[j] == PolyEval(&polys[i], xs + j * k, k);
+    PolyProgramRun(&program, n, 1, xs, out);
+    for (size_t j = 0; j < n; ++j)
+      res &= out[j] == PolyEval(&polys[i], xs + j, 1);
+    res &= PolyProgramArity(&program) == arities[i];
+    PolyProgramDestroy(&program);
+    PolyDestroy(&polys[i]);
+  }
+  // Program stałej daje jedną wartość na każdą podaną wartość.
+  Poly c = C(9);
+  PolyProgram program = PolyCompile(&c);
+  res &= PolyProgramArity(&program) == 1;
+  PolyProgramRun(&program, 3, PolyProgramArity(&program), xs, out);
+  res &= out[0] == 9 && out[1] == 9 && out[2] == 9;
+  PolyProgramDestroy(&program);
+  return res;
+}
+
+static bool HornerComposeTest(void) {
+  bool res = true;
+  Poly p = P(C(3), 0, P(C(1), 2, P(C(2), 1), 5), 1, P(C(-2), 0, C(4), 3), 6);
+  Poly q[] = {
+    P(C(1), 0, P(C(1), 1), 1, C(-2), 2),
+    P(P(C(1), 3), 0, C(5), 1)
+  };
+  const poly_coeff_t x[] = {3, -2};
+  for (size_t k = 0; k <= 2; ++k) {
+    Poly r = PolyCompose(&p, k, q);
+    poly_coeff_t y[] = {PolyEval(&q[0], x, 2), PolyEval(&q[1], x, 2)};
+    res &= PolyEval(&r, x, 2) == PolyEval(&p, y, k);
+    PolyDestroy(&r);
+  }
+  PolyDestroy(&p);
+  PolyDestroy(&q[0]);
+  PolyDestroy(&q[1]);
+  // Współczynnik zależy tylko od x_1, pod które podstawiamy zero, więc
+  // wynik jest zerowy i nie wolno liczyć potęgi q^60 dużego wielomianu.
+  Poly zero_p = P(P(C(1), 1), 60);
+  Poly big_q = PolyZero();
+  for (poly_exp_t i = 0; i < 6; ++i)
+    for (poly_exp_t j = 0; j < 5; ++j) {
+      Poly m = P(P(C(i + j + 1), j * j * 5), i * i * 3);
+      PolyAddTo(&big_q, &m);
+      PolyDestroy(&m);
+    }
+  res &= PolyTerms(&big_q) == 30;
+  res &= TestEq(PolyCompose(&zero_p, 1, &big_q), C(0), true);
+  PolyDestroy(&zero_p);
+  PolyDestroy(&big_q);
+  return res;
+}
+
+static bool PowTest(void) {
+  bool res = true;
+  Poly p = P(C(-1), 0, P(C(2), 0, C(1), 3), 1, C(5), 4);
+  Poly expected = C(1);
+  for (poly_exp_t e = 0; e < 10; ++e) {
+    Poly r = PolyPow(&p, e);
+    res &= PolyIsEq(&r, &expected);
+    PolyDestroy(&r);
+    expected = PolyMulOwn(expected, PolyClone(&p));
+  }
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  Poly c = C(3);
+  res &= TestEq(PolyPow(&c, 41), C((poly_coeff_t)(12157665459056928801UL * 3)), true);
+  return res;
+}
+
+static bool SqrTest(void) {
+  bool res = true;
+  Poly polys[] = {
+    P(C(1), 0, C(-1), 1),
+    P(P(C(1), 0, C(2), 5), 0, C(3), 4, P(C(-1), 1), 7),
+    GeneratedPoly(20, 1000, 2),
+    GeneratedPoly(300, 1, 0),
+    GeneratedPoly(10000, 1, 0),
+    GeneratedPoly(40, 3, 1)
+  };
+  for (size_t i = 0; i < sizeof (polys) / sizeof (polys)[0]; ++i) {
+    Poly q = PolyClone(&polys[i]);
+    Poly expected = PolyMul(&polys[i], &q);
+    Poly r = PolySqr(&polys[i]);
+    res &= PolyIsEq(&r, &expected);
+    PolyDestroy(&r);
+    PolyDestroy(&expected);
+    PolyDestroy(&q);
+    PolyDestroy(&polys[i]);
+  }
+  return res;
+}
+
+static bool MetadataTest(void) {
+  bool res = true;
+  Poly p = P(P(C(1), 1), 2, C(3), 5);
+  res &= PolyDeg(&p) == 5;
+  res &= PolyDegBy(&p, 1) == 1;
+  res &= PolyDegBy(&p, 2) == 0;
+  res &= PolyDepth(&p) == 2;
+  Poly q = P(P(P(C(1), 4), 3), 6);
+  PolyAddTo(&p, &q);
+  res &= PolyDeg(&p) == 13;
+  res &= PolyDepth(&p) == 3;
+  res &= PolyDegBy(&p, 0) == 6;
+  res &= PolyDegBy(&p, 2) == 4;
+  Poly r = PolyAdd(&q, &p);
+  PolyAddTo(&r, &q);
+  Poly twice = PolyMulOwn(q, C(2));
+  PolyAddTo(&p, &twice);
+  res &= PolyIsEq(&p, &r);
+  p = PolyNegOwn(p);
+  res &= !PolyIsEq(&p, &r);
+  Poly neg = PolyNeg(&r);
+  res &= PolyIsEq(&p, &neg);
+  PolyDestroy(&neg);
+  PolyAddTo(&r, &p);
+  res &= PolyIsZero(&r) && PolyDepth(&r) == 0;
+  Poly deep = P(P(P(C(1), 1), 1), 1);
+  Poly other = P(P(P(C(2), 1), 1), 1);
+  res &= !PolyIsEq(&deep, &other) && PolyDeg(&deep) == 3;
+  PolyDestroy(&deep);
+  PolyDestroy(&other);
+  PolyDestroy(&twice);
+  PolyDestroy(&p);
+  PolyDestroy(&r);
+  return res;
+}
+
+static bool CopyOnWriteTest(void) {
+  bool res = true;
+  Poly p = P(P(C(1), 0, C(1), 1), 0, P(C(2), 3), 2);
+  Poly expected = P(P(C(1), 0, C(1), 1), 0, P(C(2), 3), 2);
+  Poly a = PolyClone(&p);
+  Poly b = PolyClone(&a);
+  Poly one = P(P(C(1), 1), 0);
+  PolyAddTo(&a, &one);
+  b = PolyNegOwn(b);
+  Poly c = PolyMulOwn(PolyClone(&p), C(3));
+  Poly d = PolyAddOwn(PolyClone(&p), PolyClone(&p));
+  Poly e = PolySubOwn(PolyClone(&p), PolyClone(&p));
+  res &= PolyIsEq(&p, &expected);
+  Poly a_expected = P(P(C(1), 0, C(2), 1), 0, P(C(2), 3), 2);
+  res &= PolyIsEq(&a, &a_expected);
+  Poly b_expected = PolyNeg(&expected);
+  res &= PolyIsEq(&b, &b_expected);
+  Poly d_expected = PolyMulOwn(PolyClone(&expected), C(2));
+  res &= PolyIsEq(&d, &d_expected);
+  PolyAddTo(&c, &b);
+  PolyAddTo(&c, &b);
+  PolyAddTo(&c, &b);
+  res &= PolyIsZero(&c) && PolyIsZero(&e);
+  Poly sqr = PolyMul(&p, &a);
+  Poly sqr_expected = PolyMul(&expected, &a_expected);
+  res &= PolyIsEq(&sqr, &sqr_expected);
+  res &= PolyIsEq(&p, &expected);
+  PolyDestroy(&p);
+  PolyDestroy(&expected);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&one);
+  PolyDestroy(&c);
+  PolyDestroy(&d);
+  PolyDestroy(&e);
+  PolyDestroy(&a_expected);
+  PolyDestroy(&b_expected);
+  PolyDestroy(&d_expected);
+  PolyDestroy(&sqr);
+  PolyDestroy(&sqr_expected);
+  return res;
+}
+
+static bool InternTest(void) {
+  bool res = true;
+  Poly p = PolyInternOwn(P(P(C(1), 0, C(1), 1), 0, P(C(1), 0, C(1), 1), 3));
+  Poly q = PolyInternOwn(P(P(C(1), 0, C(1), 1), 0, P(C(1), 0, C(1), 1), 3));
+  Poly r = PolyInternOwn(P(P(C(1), 0, C(1), 1), 0, P(C(1), 0, C(2), 1), 3));
+  res &= p.arr == q.arr && p.arr != r.arr;
+  res &= p.arr[0].p.arr == p.arr[1].p.arr && p.arr[0].p.arr == r.arr[0].p.arr;
+  res &= PolyIsEq(&p, &q) && !PolyIsEq(&p, &r);
+  Poly one = P(P(C(1), 2), 1);
+  PolyAddTo(&q, &one);
+  res &= !PolyIsEq(&p, &q);
+  Poly s = PolySub(&q, &one);
+  res &= PolyIsEq(&p, &s);
+  s = PolyInternOwn(s);
+  res &= s.arr == p.arr;
+  PolyDestroy(&p);
+  PolyDestroy(&s);
+  Poly t = PolyInternOwn(P(P(C(1), 0, C(1), 1), 0, P(C(1), 0, C(1), 1), 3));
+  Poly u = PolyInternOwn(PolyClone(&t));
+  res &= t.arr == u.arr;
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  PolyDestroy(&one);
+  PolyDestroy(&t);
+  PolyDestroy(&u);
+  return res;
+}
+
+static bool CacheTest(void) {
+  bool res = true;
+  PolyCacheSetLimit(1 << 20);
+  Poly p = GeneratedPoly(40, 3, 1);
+  Poly one = C(1);
+  Poly q = PolyAdd(&p, &one);
+  Poly r1 = PolyMul(&p, &q);
+  Poly q_copy = PolyAddOwn(PolyClone(&q), PolyZero());
+  Poly r2 = PolyMul(&p, &q_copy);
+  res &= PolyIsEq(&r1, &r2) && r1.arr == r2.arr;
+  Poly pow1 = PolyPow(&q, 3);
+  Poly pow2 = PolyPow(&q, 3);
+  Poly pow3 = PolyPow(&q, 4);
+  Poly expected = PolyMul(&pow1, &q);
+  res &= PolyIsEq(&pow1, &pow2) && PolyIsEq(&pow3, &expected);
+  Poly small = P(P(C(1), 0, C(2), 1), 0, C(3), 2);
+  Poly args[] = {small, q};
+  Poly c1 = PolyCompose(&small, 2, args);
+  Poly c2 = PolyCompose(&small, 2, args);
+  res &= PolyIsEq(&c1, &c2);
+  PolyCacheStats stats = PolyCacheGetStats();
+  res &= stats.hits == 3 && stats.misses == 5 && stats.entries == 5;
+  res &= stats.bytes <= stats.limit && stats.evictions == 0;
+  PolyCacheSetLimit(stats.bytes / 2);
+  stats = PolyCacheGetStats();
+  res &= stats.evictions > 0 && stats.bytes <= stats.limit;
+  PolyCacheClear();
+  PolyCacheSetLimit(0);
+  Poly r3 = PolyMul(&p, &q);
+  res &= PolyIsEq(&r1, &r3) && PolyCacheGetStats().misses == 0;
+  Poly polys[] = {p, q, q_copy, r1, r2, r3, pow1, pow2, pow3, expected, small, c1, c2};
+  for (size_t i = 0; i < sizeof (polys) / sizeof (polys)[0]; ++i)
+    PolyDestroy(&polys[i]);
+  return res;
+}
+
+static bool CacheMemoryTest(void) {
+  bool res = true;
+  const size_t limit = 256 << 10;
+  PolyCacheSetLimit(limit);
+  size_t before = PolyPoolGetStats().in_use;
+  for (poly_exp_t i = 0; i < 400; ++i) {
+    // Różne odstępy wykładników dają różne argumenty w każdym kroku.
+    Poly p = GeneratedPoly(3, i + 1, 2);
+    Poly q = GeneratedPoly(2 + (size_t)i % 3, i + 2, 2);
+    Poly r = PolyMul(&p, &q);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+  }
+  // Pozostała pamięć puli należy już tylko do zapamiętanych wielomianów.
+  PolyCacheStats stats = PolyCacheGetStats();
+  size_t held = PolyPoolGetStats().in_use - before;
+  res &= stats.evictions > 0 && stats.bytes <= limit;
+  res &= held > 0 && held <= stats.bytes;
+  PolyCacheClear();
+  PolyCacheSetLimit(0);
+  res &= PolyPoolGetStats().in_use == before;
+  return res;
+}
+
+static bool ArenaTest(void) {
+  bool res = true;
+  Arena arena = {.block = NULL};
+  ArenaMark empty = ArenaGetMark(&arena);
+  char *a = ArenaAlloc(&arena, 3);
+  long long *b = ArenaAlloc(&arena, 5 * sizeof(long long));
+  res &= (size_t)b % sizeof(void *) == 0 && (char *)b >= a + 3;
+  ArenaMark mark = ArenaGetMark(&arena);
+  char *big = ArenaAlloc(&arena, (size_t)1 << 20);
+  memset(big, 1, (size_t)1 << 20);
+  long long *c = ArenaAlloc(&arena, sizeof(long long));
+  *c = 1;
+  ArenaRelease(&arena, mark);
+  long long *d = ArenaAlloc(&arena, sizeof(long long));
+  res &= d == b + 5;
+  ArenaRelease(&arena, empty);
+  res &= ArenaAlloc(&arena, 3) == a;
+  ArenaFree(&arena);
+  res &= arena.block == NULL;
+  // Zagnieżdżone znaczniki: po zwolnieniu do znacznika pamięć jest używana
+  // ponownie od tego samego miejsca, także po przejściu do nowego bloku.
+  ArenaMark outer = ArenaGetMark(&arena);
+  char *x = ArenaAlloc(&arena, 100);
+  ArenaMark inner = ArenaGetMark(&arena);
+  char *y = ArenaAlloc(&arena, 200);
+  ArenaMark innermost = ArenaGetMark(&arena);
+  char *z = ArenaAlloc(&arena, (size_t)1 << 17);
+  memset(z, 2, (size_t)1 << 17);
+  ArenaRelease(&arena, innermost);
+  res &= (char *)ArenaAlloc(&arena, 1) >= y + 200;
+  ArenaRelease(&arena, inner);
+  res &= ArenaAlloc(&arena, 200) == y;
+  ArenaRelease(&arena, outer);
+  res &= ArenaAlloc(&arena, 100) == x;
+  ArenaRelease(&arena, outer);
+  res &= ArenaAlloc(&arena, (size_t)1 << 17) != NULL && ArenaAlloc(&arena, 8) != NULL;
+  ArenaRelease(&arena, outer);
+  res &= ArenaAlloc(&arena, 100) == x;
+  ArenaFree(&arena);
+  // Arena biblioteki może zostać zwolniona między operacjami.
+  Poly p = P(C(1), 0, C(2), 40, C(3), 90);
+  Poly sqr_before = PolyMul(&p, &p);
+  PolyScratchFree();
+  Poly sqr_after = PolyMul(&p, &p);
+  res &= PolyIsEq(&sqr_before, &sqr_after);
+  PolyScratchFree();
+  PolyDestroy(&p);
+  PolyDestroy(&sqr_before);
+  PolyDestroy(&sqr_after);
+  return res;
+}
+
+static bool PoolTest(void) {
+  bool res = true;
+  PolyPoolStats before = PolyPoolGetStats();
+  Poly p = P(P(C(1), 0, C(2), 1), 0, C(3), 2);
+  PolyPoolStats during = PolyPoolGetStats();
+  res &= during.in_use > before.in_use && during.resident >= during.in_use;
+  PolyDestroy(&p);
+  res &= PolyPoolGetStats().in_use == before.in_use;
+  Poly q = P(P(C(1), 0, C(2), 1), 0, C(3), 2);
+  PolyPoolStats after = PolyPoolGetStats();
+  res &= after.hits >= during.hits + 2 && after.misses == during.misses;
+  Poly big = GeneratedPoly(100, 1, 0);
+  res &= PolyPoolGetStats().bypassed > after.bypassed;
+  Poly r = PolyMul(&q, &big);
+  res &= PolyDeg(&r) == 101;
+  PolyDestroy(&q);
+  PolyDestroy(&big);
+  PolyDestroy(&r);
+  res &= PolyPoolGetStats().in_use == before.in_use;
+  return res;
+}
+
+static bool FrozenTest(void) {
+  bool res = true;
+  Poly p = GeneratedPoly(20, 3, 2);
+  Poly q = P(C(1), 0, P(C(-1), 0, C(2), 4), 2);
+  Poly zero = C(0);
+  Poly leaf = P(C(3), 1, C(-2), 5);
+  Poly polys[] = {p, q, zero, C(7), leaf};
+  for (size_t i = 0; i < sizeof (polys) / sizeof (polys)[0]; ++i) {
+    PolyFrozen f = PolyFreeze(&polys[i]);
+    PolyFrozen g = PolyFrozenClone(&f);
+    Poly back = PolyThaw(&g);
+    res &= PolyIsEq(&back, &polys[i]) && PolyFrozenIsEq(&f, &g);
+    res &= PolyFrozenDeg(&g) == PolyDeg(&polys[i]);
+    for (size_t var = 0; var < 4; ++var)
+      res &= PolyFrozenDegBy(&g, var) == PolyDegBy(&polys[i], var);
+    for (poly_coeff_t x = -2; x <= 2; ++x) {
+      Poly a = PolyFrozenAt(&g, x);
+      Poly b = PolyAt(&polys[i], x);
+      res &= PolyIsEq(&a, &b);
+      PolyDestroy(&a);
+      PolyDestroy(&b);
+    }
+    PolyDestroy(&back);
+    PolyFrozenDestroy(&f);
+    PolyFrozenDestroy(&g);
+  }
+  PolyFrozen f = PolyFreeze(&p);
+  PolyFrozen g = PolyFreeze(&q);
+  res &= !PolyFrozenIsEq(&f, &g);
+  res &= f.leaves == 20 * 3 * 3 && f.count == 20 + 20 * 3;
+  char *buf = NULL;
+  size_t len = 0;
+  FILE *stream = open_memstream(&buf, &len);
+  PolyFrozenPrint(&g, stream);
+  fclose(stream);
+  res &= strcmp(buf, "(1,0)+((-1,0)+(2,4),2)") == 0;
+  free(buf);
+  PolyFrozenDestroy(&f);
+  PolyFrozenDestroy(&g);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&leaf);
+  return res;
+}
+
+static bool LeafMulTest(void) {
+  bool res = true;
+  Poly p = P(C(3), 1, C(-2), 70000, C(5), 1 << 20, C(1), 1 << 29);
+  Poly q = P(C(2), 0, C(7), 69999, C(-1), 1 << 20, C(4), (1 << 29) + 1);
+  Poly r = PolyMul(&p, &q);
+  Poly expected = PolyZero();
+  for (size_t i = 0; i < p.size; ++i)
+    for (size_t j = 0; j < q.size; ++j) {
+      Poly m = P(C(p.arr[i].p.coeff * q.arr[j].p.coeff), p.arr[i].exp + q.arr[j].exp);
+      PolyAddTo(&expected, &m);
+      PolyDestroy(&m);
+    }
+  res &= PolyIsEq(&r, &expected) && PolyDeg(&r) == (1 << 30) + 1;
+  Mono big_p[80], big_q[80];
+  for (size_t i = 0; i < 80; ++i) {
+    big_p[i] = (Mono) {.p = C((poly_coeff_t)i % 7 - 3), .exp = (poly_exp_t)(i * 100003)};
+    big_q[i] = (Mono) {.p = C((poly_coeff_t)i % 5 + 1), .exp = (poly_exp_t)(i * 7919 + 1)};
+  }
+  Poly big_a = PolyAddMonos(80, big_p);
+  Poly big_b = PolyAddMonos(80, big_q);
+  Poly big_r = PolyMul(&big_a, &big_b);
+  Poly big_expected = PolyZero();
+  for (size_t i = 0; i < big_a.size; ++i) {
+    Poly m = P(C(big_a.arr[i].p.coeff), big_a.arr[i].exp);
+    Poly t = PolyMul(&m, &big_b);
+    PolyAddTo(&big_expected, &t);
+    PolyDestroy(&m);
+    PolyDestroy(&t);
+  }
+  res &= PolyIsEq(&big_r, &big_expected);
+  PolyDestroy(&big_a);
+  PolyDestroy(&big_b);
+  PolyDestroy(&big_r);
+  PolyDestroy(&big_expected);
+  Poly a = P(C(1), 0, C(1), 1 << 20);
+  Poly b = P(C(-1), 0, C(1), 1 << 20);
+  Poly s = PolyMul(&a, &b);
+  Poly s_expected = P(C(-1), 0, C(1), 1 << 21);
+  res &= PolyIsEq(&s, &s_expected) && s.size == 2;
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  PolyDestroy(&expected);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&s);
+  PolyDestroy(&s_expected);
+  return res;
+}
+
+static bool GallopMergeTest(void) {
+  bool res = true;
+  // Przeplatane serie po 37 wykładników; co 11. wykładnik jest w obu.
+  Mono p_monos[1000], q_monos[1000], sum_monos[1000];
+  size_t p_size = 0, q_size = 0;
+  for (size_t i = 0; i < 1000; ++i) {
+    bool in_p = (i / 37) % 2 == 0 || i % 11 == 0;
+    bool in_q = (i / 37) % 2 == 1 || i % 11 == 0;
+    poly_coeff_t sum = 0;
+    if (in_p) {
+      p_monos[p_size++] = (Mono) {.p = C(1), .exp = (poly_exp_t)i};
+      sum += 1;
+    }
+    if (in_q) {
+      q_monos[q_size++] = (Mono) {.p = C(i % 11 == 0 ? -1 : 2), .exp = (poly_exp_t)i};
+      sum += i % 11 == 0 ? -1 : 2;
+    }
+    sum_monos[i] = (Mono) {.p = C(sum), .exp = (poly_exp_t)i};
+  }
+  Poly p = PolyAddMonos(p_size, p_monos);
+  Poly q = PolyAddMonos(q_size, q_monos);
+  Poly expected = PolyAddMonos(1000, sum_monos);
+  Poly r = PolyAdd(&p, &q);
+  Poly r2 = PolyAdd(&q, &p);
+  Poly acc = PolyClone(&p);
+  PolyAddTo(&acc, &q);
+  Poly own = PolyAddOwn(PolyClone(&q), PolyClone(&p));
+  Poly d = PolySub(&r, &q);
+  res &= PolyIsEq(&r, &expected) && PolyIsEq(&r2, &expected);
+  res &= PolyIsEq(&acc, &expected) && PolyIsEq(&own, &expected);
+  res &= PolyIsEq(&d, &p) && r.size == expected.size;
+  // Cały drugi składnik przed lub za pierwszym.
+  Poly low = P(C(1), 0, C(2), 1, C(3), 2);
+  Poly high = P(C(4), 5000, C(5), 5001);
+  Poly lh = PolyAdd(&low, &high);
+  Poly hl = PolyClone(&high);
+  PolyAddTo(&hl, &low);
+  Poly lh_expected = P(C(1), 0, C(2), 1, C(3), 2, C(4), 5000, C(5), 5001);
+  res &= PolyIsEq(&lh, &lh_expected) && PolyIsEq(&hl, &lh_expected);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&expected);
+  PolyDestroy(&r);
+  PolyDestroy(&r2);
+  PolyDestroy(&acc);
+  PolyDestroy(&own);
+  PolyDestroy(&d);
+  PolyDestroy(&low);
+  PolyDestroy(&high);
+  PolyDestroy(&lh);
+  PolyDestroy(&hl);
+  PolyDestroy(&lh_expected);
+  return res;
+}
+
+static Poly NaiveMul(const Poly *p, const Poly *q) {
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return C(p->coeff * q->coeff);
+  Mono p_mono = {.p = *p, .exp = 0}, q_mono = {.p = *q, .exp = 0};
+  size_t p_size = PolyIsCoeff(p) ? 1 : p->size;
+  size_t q_size = PolyIsCoeff(q) ? 1 : q->size;
+  const Mono *p_arr = PolyIsCoeff(p) ? &p_mono : p->arr;
+  const Mono *q_arr = PolyIsCoeff(q) ? &q_mono : q->arr;
+  Poly res = PolyZero();
+  for (size_t i = 0; i < p_size; ++i)
+    for (size_t j = 0; j < q_size; ++j) {
+      Poly c = NaiveMul(&p_arr[i].p, &q_arr[j].p);
+      if (PolyIsZero(&c))
+        continue;
+      Poly m = P(c, p_arr[i].exp + q_arr[j].exp);
+      PolyAddTo(&res, &m);
+      PolyDestroy(&m);
+    }
+  return res;
+}
+
+static Poly TermPoly(poly_coeff_t c, size_t n, const poly_exp_t exps[]) {
+  Poly p = C(c);
+  for (size_t v = n; c != 0 && v-- > 0;)
+    p = P(p, exps[v]);
+  return p;
+}
+
+static bool MulMatchesNaive(Poly p, Poly q) {
+  Poly expected = NaiveMul(&p, &q);
+  Poly r = PolyMul(&p, &q);
+  Poly s = PolyMul(&p, &p);
+  Poly s_expected = NaiveMul(&p, &p);
+  bool res = PolyIsEq(&r, &expected) && PolyIsEq(&s, &s_expected);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  PolyDestroy(&expected);
+  PolyDestroy(&s);
+  PolyDestroy(&s_expected);
+  return res;
+}
+
+static bool KroneckerMulTest(void) {
+  bool res = true;
+  // Gęste wielomiany trzech zmiennych o przesuniętych wykładnikach:
+  // 125 * 125 iloczynów, więc iloczyn liczy podstawienie Kroneckera.
+  Poly a = PolyZero(), b = PolyZero();
+  for (poly_exp_t i = 0; i < 5; ++i)
+    for (poly_exp_t j = 0; j < 5; ++j)
+      for (poly_exp_t k = 0; k < 5; ++k) {
+        Poly ta = TermPoly(1 + i - 2 * j + 3 * k, 3, (poly_exp_t[]) {i + 3, j, k + 1});
+        Poly tb = TermPoly(2 - i + j * k, 3, (poly_exp_t[]) {i, j + 2, k});
+        PolyAddTo(&a, &ta);
+        PolyAddTo(&b, &tb);
+        PolyDestroy(&ta);
+        PolyDestroy(&tb);
+      }
+  res &= PolyTerms(&a) * PolyTerms(&b) >= 256;
+  res &= MulMatchesNaive(a, b);
+  // Ponad KRONECKER_MAX_VARS (16) zmiennych.
+  Poly deep_a = PolyZero(), deep_b = PolyZero();
+  for (size_t t = 0; t < 20; ++t) {
+    poly_exp_t exps[17] = {0};
+    exps[t % 17] = (poly_exp_t)t + 1;
+    exps[16] = 1;
+    Poly ta = TermPoly((poly_coeff_t)t + 1, 17, exps);
+    exps[(t + 5) % 17] += 2;
+    Poly tb = TermPoly(3 - (poly_coeff_t)t, 17, exps);
+    PolyAddTo(&deep_a, &ta);
+    PolyAddTo(&deep_b, &tb);
+    PolyDestroy(&ta);
+    PolyDestroy(&tb);
+  }
+  res &= MulMatchesNaive(deep_a, deep_b);
+  // Tablica iloczynu dłuższa niż 2^24.
+  Poly long_a = PolyZero(), long_b = PolyZero();
+  for (poly_exp_t i = 0; i < 5; ++i)
+    for (poly_exp_t j = 0; j < 5; ++j) {
+      Poly ta = TermPoly(i + j + 1, 2, (poly_exp_t[]) {1000 * i, 1000 * j});
+      Poly tb = TermPoly(i - j - 7, 2, (poly_exp_t[]) {999 * j, 1001 * i});
+      PolyAddTo(&long_a, &ta);
+      PolyAddTo(&long_b, &tb);
+      PolyDestroy(&ta);
+      PolyDestroy(&tb);
+    }
+  res &= MulMatchesNaive(long_a, long_b);
+  // Rzadkie wielomiany jednej zmiennej: stosunek pracy na tablicach do
+  // liczby iloczynów przekracza KRONECKER_MAX_RATIO.
+  Poly sparse_a = PolyZero(), sparse_b = PolyZero();
+  for (poly_exp_t i = 0; i < 20; ++i) {
+    Poly ta = P(C(i + 1), i * i * 250);
+    Poly tb = P(C(2 * i - 19), i * 4001);
+    PolyAddTo(&sparse_a, &ta);
+    PolyAddTo(&sparse_b, &tb);
+    PolyDestroy(&ta);
+    PolyDestroy(&tb);
+  }
+  res &= MulMatchesNaive(sparse_a, sparse_b);
+  return res;
+}
+
+static void SchoolbookDense(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m,
+                            dense_coeff_t *r) {
+  for (size_t i = 0; i < n + m - 1; ++i)
+    r[i] = 0;
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < m; ++j)
+      r[i + j] += a[i] * b[j];
+}
+
+static void FillDense(dense_coeff_t *a, size_t n, unsigned long seed) {
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    a[i] = seed;
+  }
+}
+
+static bool DenseMulMatches(const dense_coeff_t *a, size_t n, const dense_coeff_t *b, size_t m) {
+  dense_coeff_t *r = malloc((n + m - 1) * sizeof (dense_coeff_t));
+  dense_coeff_t *expected = malloc((n + m - 1) * sizeof (dense_coeff_t));
+  CHECK_PTR(r);
+  CHECK_PTR(expected);
+  DenseMul(a, n, b, m, r);
+  SchoolbookDense(a, n, b, m, expected);
+  bool res = memcmp(r, expected, (n + m - 1) * sizeof (dense_coeff_t)) == 0;
+  if (a == b && n == m) {
+    DenseSqr(a, n, r);
+    res &= memcmp(r, expected, (n + m - 1) * sizeof (dense_coeff_t)) == 0;
+  }
+  free(r);
+  free(expected);
+  return res;
+}
+
+static bool KaratsubaMulTest(void) {
+  bool res = true;
+  // Długości, dla których rekurencja algorytmu Karatsuby dochodzi do
+  // kawałków długości 31 i 32, czyli do progu KARATSUBA_THRESHOLD.
+  const size_t lengths[] = {992, 1000, 1024};
+  dense_coeff_t *a = malloc(3000 * sizeof (dense_coeff_t));
+  dense_coeff_t *b = malloc(20000 * sizeof (dense_coeff_t));
+  CHECK_PTR(a);
+  CHECK_PTR(b);
+  FillDense(a, 3000, 1);
+  FillDense(b, 20000, 2);
+  for (size_t i = 0; i < sizeof (lengths) / sizeof (lengths)[0]; ++i) {
+    res &= DenseMulMatches(a, lengths[i], b, lengths[i]);
+    res &= DenseMulMatches(a, lengths[i], a, lengths[i]);
+    res &= DenseMulMatches(a, lengths[i], b, lengths[i] + 1);
+  }
+  // Czynniki różnej długości (BalancedMul dzieli dłuższy na kawałki,
+  // a ostatni kawałek jest niepełny); 527 daje w rekurencji kawałki 33.
+  res &= DenseMulMatches(a, 527, b, 20000);
+  res &= DenseMulMatches(a, 3000, b, 992);
+  // Zerowe współczynniki nie mogą zmieniać wyniku.
+  for (size_t i = 0; i < 3000; i += 3)
+    a[i] = 0;
+  res &= DenseMulMatches(a, 1000, b, 1000);
+  free(a);
+  free(b);
+  return res;
+}
+
+static bool NttMulTest(void) {
+  bool res = true;
+  // Długości nie są potęgami dwójki, a iloczyn jest na tyle duży, że liczy go
+  // transformata modulo trzy liczby pierwsze z odtwarzaniem modulo 2^64.
+  const size_t n = 3001, m = 2500;
+  dense_coeff_t *a = malloc(n * sizeof (dense_coeff_t));
+  dense_coeff_t *b = malloc(m * sizeof (dense_coeff_t));
+  CHECK_PTR(a);
+  CHECK_PTR(b);
+  // Współczynniki bliskie 2^62 i -2^62.
+  for (size_t i = 0; i < n; ++i)
+    a[i] = i % 2 == 0 ? ((dense_coeff_t)1 << 62) - i : -((dense_coeff_t)1 << 62) + 3 * i;
+  for (size_t i = 0; i < m; ++i)
+    b[i] = i % 3 == 0 ? -((dense_coeff_t)1 << 62) + i : ((dense_coeff_t)1 << 62) - 7 * i;
+  res &= DenseMulMatches(a, n, b, m);
+  res &= DenseMulMatches(a, n, a, n);
+  // Pełne 64-bitowe współczynniki.
+  FillDense(a, n, 3);
+  FillDense(b, m, 4);
+  res &= DenseMulMatches(a, n, b, m);
+  res &= DenseMulMatches(b, m, b, m);
+  free(a);
+  free(b);
+  return res;
+}
+
+/**
+ * Sprawdza sumę jednomianów @f$c_i x^{e_i}@f$ (zob. MonosSumMatches).
+ * @param count liczba jednomianów
+ * @param exps wykładniki @f$e_i@f$
+ * @param coeffs współczynniki @f$c_i@f$
+ * @return czy suma jest poprawna
+ */
+static bool SortMatches(size_t count, const poly_exp_t exps[], const poly_coeff_t coeffs[]) {
+  Mono *monos = calloc(count, sizeof (Mono));
+  CHECK_PTR(monos);
+  for (size_t i = 0; i < count; ++i)
+    monos[i] = M(C(coeffs[i]), exps[i]);
+  return MonosSumMatches(count, monos);
+}
+
+/**
+ * Sprawdza sortowanie jednomianów dla list dłuższych niż próg sortowania
+ * przez wstawianie: przemieszanych, odwrotnie posortowanych, z wieloma
+ * powtórzeniami wykładników i z wykładnikami bliskimi INT_MAX.
+ */
+static bool MonosSortTest(void) {
+  const size_t count = 1000;
+  bool res = true;
+  poly_exp_t *exps = malloc(count * sizeof (poly_exp_t));
+  poly_coeff_t *coeffs = malloc(count * sizeof (poly_coeff_t));
+  CHECK_PTR(exps);
+  CHECK_PTR(coeffs);
+
+  // Permutacja wykładników 0, ..., count - 1.
+  for (size_t i = 0; i < count; ++i) {
+    exps[i] = (poly_exp_t)(i * 7919 % count);
+    coeffs[i] = 2 * (poly_coeff_t)i - 999;
+  }
+  res &= SortMatches(count, exps, coeffs);
+  res &= SortMatches(33, exps, coeffs);
+
+  // Ściśle malejące wykładniki oraz malejące z powtórzeniami.
+  for (size_t i = 0; i < count; ++i) {
+    exps[i] = (poly_exp_t)(count - i);
+    coeffs[i] = (poly_coeff_t)i + 1;
+  }
+  res &= SortMatches(count, exps, coeffs);
+  for (size_t i = 0; i < count; ++i)
+    exps[i] = (poly_exp_t)((count - i) / 3);
+  res &= SortMatches(count, exps, coeffs);
+
+  // Pięć różnych wykładników; współczynniki przy każdym z nich się znoszą.
+  for (size_t i = 0; i < count; ++i) {
+    exps[i] = (poly_exp_t)(i % 5);
+    coeffs[i] = i % 2 == 0 ? 1 : -1;
+  }
+  res &= SortMatches(count, exps, coeffs);
+  for (size_t i = 0; i < count; ++i)
+    exps[i] = (poly_exp_t)(i * i % 3);
+  res &= SortMatches(count, exps, coeffs);
+
+  // Wykładniki bliskie INT_MAX różnią się na wszystkich bajtach klucza.
+  for (size_t i = 0; i < count; ++i) {
+    exps[i] = INT_MAX - (poly_exp_t)(i * 37 % 64) * 0x01010101;
+    coeffs[i] = (poly_coeff_t)(i % 7) + 1;
+  }
+  res &= SortMatches(count, exps, coeffs);
+  for (size_t i = 0; i < count; ++i)
+    exps[i] = INT_MAX - (poly_exp_t)(i * 13 % 40);
+  res &= SortMatches(count, exps, coeffs);
+
+  free(exps);
+  free(coeffs);
+
+  // Lista na tyle długa, że przy PARALLEL_SORT sortuje ją kilka wątków.
+  const size_t big_count = (1 << 20) + 1;
+  const poly_exp_t base = INT_MAX - (poly_exp_t)big_count;
+  Mono *monos = malloc(big_count * sizeof (Mono));
+  CHECK_PTR(monos);
+  for (size_t i = 0; i < big_count; ++i)
+    monos[i] = M(C(1), base + (poly_exp_t)(i * 65537 % big_count));
+  Poly sum = PolyOwnMonos(big_count, monos);
+  Poly one = C(1);
+  res &= PolyTerms(&sum) == big_count;
+  for (size_t i = 0; res && i < big_count; ++i)
+    res &= MonoGetExp(&sum.arr[i]) == base + (poly_exp_t)i && PolyIsEq(&sum.arr[i].p, &one);
+  PolyDestroy(&sum);
+  return res;
+}
+
+/**
+ * Sprawdza odejmowanie, w którym @f$q@f$ ma zagnieżdżone współczynniki,
+ * a wyrazy znoszą się na wewnętrznych poziomach, więc wynik musi zostać
+ * sprowadzony do postaci normalnej.
+ */
+static bool NestedSubTest(void) {
+  bool res = true;
+  // Współczynnik minus wielomian o zagnieżdżonych współczynnikach.
+  res &= TestSub(C(5),
+                 P(P(C(2), 1), 0, C(3), 2),
+                 P(P(C(5), 0, C(-2), 1), 0, C(-3), 2));
+  res &= TestSub(C(0),
+                 P(P(C(1), 0, P(C(2), 3), 1), 1, C(-4), 2),
+                 P(P(C(-1), 0, P(C(-2), 3), 1), 1, C(4), 2));
+  // Jednomian stopnia 0 znika w całości.
+  res &= TestSub(P(P(C(1), 0, C(2), 1), 0, C(4), 3),
+                 P(P(C(1), 0, C(2), 1), 0, C(1), 3),
+                 P(C(3), 3));
+  // Współczynnik przy x^2 upraszcza się do stałej.
+  res &= TestSub(P(P(C(7), 0, C(2), 1), 2),
+                 P(P(C(2), 1), 2),
+                 P(C(7), 2));
+  // Znoszenie na trzecim poziomie upraszcza drugi poziom do stałej.
+  res &= TestSub(P(P(P(C(1), 0, C(1), 1), 1), 2),
+                 P(P(P(C(1), 1), 1), 2),
+                 P(P(C(1), 1), 2));
+  // Zostaje jedynie wyraz stopnia 0, więc wynik jest współczynnikiem.
+  res &= TestSub(P(C(4), 0, P(C(1), 0, P(C(3), 2), 1), 3),
+                 P(P(C(1), 0, P(C(3), 2), 1), 3),
+                 C(4));
+  res &= TestSub(P(P(C(4), 0, C(1), 1), 0, P(C(1), 1), 3),
+                 P(P(C(1), 1), 0, P(C(1), 1), 3),
+                 C(4));
+
+  Poly p = P(P(C(1), 0, P(C(2), 1, C(3), 4), 2), 0, P(C(-5), 3), 1, C(6), 9);
+  Poly q = PolySub(&p, &p);
+  res &= PolyIsCoeff(&q) && PolyIsZero(&q);
+  PolyDestroy(&q);
+
+  // Długa seria jednomianów q przepisywana z negacją między jednomianami p.
+  Mono monos[40];
+  for (size_t i = 0; i < 40; ++i) {
+    Poly c = i % 2 == 0 ? C((poly_coeff_t)i + 1) : P(C((poly_coeff_t)i), 0, P(C(1), 2), 1);
+    monos[i] = M(c, (poly_exp_t)(2 * i + 1));
+  }
+  q = PolyAddMonos(40, monos);
+  Poly expected = PolyAddOwn(PolyClone(&p), PolyNegOwn(PolyClone(&q)));
+  Poly diff = PolySub(&p, &q);
+  res &= PolyIsEq(&diff, &expected);
+  PolyDestroy(&diff);
+  diff = PolySub(&q, &q);
+  res &= PolyIsZero(&diff);
+  PolyDestroy(&diff);
+  PolyDestroy(&expected);
+  PolyDestroy(&q);
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Sprawdza, jak pamięć podręczna wpływa na komendy kalkulatora: domyślnie
+ * jest wyłączona i negacja iloczynu odbywa się w miejscu, a po włączeniu
+ * iloczyn jest zapamiętany, więc negacja musi go skopiować.
+ */
+static bool CalcCacheTest(void) {
+  bool res = true;
+  Stack *stack = StackCreate(4);
+  Poly p = GeneratedPoly(40, 3, 1);
+  Poly q = GeneratedPoly(30, 5, 0);
+  Poly product = PolyMul(&p, &q);
+  Poly expected = PolyNeg(&product);
+  for (int on = 0; on < 2; ++on) {
+    if (on)
+      CalcCache(true);
+    for (int round = 0; round < 2; ++round) {
+      StackPush(stack, PolyClone(&q));
+      StackPush(stack, PolyClone(&p));
+      CalcMul(stack, 1);
+      const Mono *arr = StackPeek(stack)->arr;
+      CalcNeg(stack, 1);
+      res &= PolyIsEq(StackPeek(stack), &expected);
+      res &= (StackPeek(stack)->arr == arr) == !on;
+      StackPop(stack);
+    }
+    PolyCacheStats stats = PolyCacheGetStats();
+    res &= on ? stats.hits == 1 && stats.entries == 1 : stats.entries == 0;
+  }
+  CalcCache(false);
+  res &= PolyCacheGetStats().entries == 0;
+  PolyCacheClear();
+  StackDestroy(stack);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&product);
+  PolyDestroy(&expected);
+  return res;
+}
+
 /** GRUPY TESTÓW **/
 
 static bool SimpleNegGroup(void) {
@@ -4041,6 +5141,32 @@ static const test_list_t test_list[] = {
   TEST(SubTest1),
   TEST(SubTest2),
   TEST(ArithmeticGroup),
+  TEST(OwnArithmeticTest),
+  TEST(AccumulateTest),
+  TEST(AddMonosCollisionTest),
+  TEST(HornerAtTest),
+  TEST(AtManyTest),
+  TEST(EvalTest),
+  TEST(CompileTest),
+  TEST(HornerComposeTest),
+  TEST(PowTest),
+  TEST(SqrTest),
+  TEST(MetadataTest),
+  TEST(CopyOnWriteTest),
+  TEST(InternTest),
+  TEST(CacheTest),
+  TEST(CacheMemoryTest),
+  TEST(ArenaTest),
+  TEST(PoolTest),
+  TEST(FrozenTest),
+  TEST(LeafMulTest),
+  TEST(GallopMergeTest),
+  TEST(KroneckerMulTest),
+  TEST(KaratsubaMulTest),
+  TEST(NttMulTest),
+  TEST(MonosSortTest),
+  TEST(NestedSubTest),
+  TEST(CalcCacheTest),
   TEST(IsEqTest),
   TEST(RarePolynomialTest),
   TEST(MemoryThiefTest),
@@ -75,3 +75,11 @@ void StackPop(Stack *stack) {
 
     PolyDestroy(&stack->arr[stack->size]);
 }
+
+Poly StackTake(Stack *stack) {
+    assert(!StackIsEmpty(stack));
+
+    stack->size--;
+
+    return stack->arr[stack->size];
+}
@@ -82,4 +82,12 @@ Poly* StackPeekSecond(const Stack *stack);
  */
 void StackPop(Stack *stack);
 
+/**
+ * Zdejmuje wielomian z wierzchu stosu i przekazuje go na własność
+ * wywołującemu. Zakłada, że stos jest niepusty.
+ * @param[in, out] stack : stos
+ * @return wielomian z wierzchu stosu
+ */
+Poly StackTake(Stack *stack);
+
 #endif